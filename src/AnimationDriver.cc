@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "AnimationDriver.h"
+
+// KDecoration
+#include <KDecoration2/Decoration>
+
+// Qt
+#include <QGuiApplication>
+#include <QScreen>
+#include <QtMath> // qCeil
+
+namespace Material
+{
+
+AnimationDriver &AnimationDriver::self()
+{
+    static AnimationDriver driver;
+    return driver;
+}
+
+AnimationDriver::AnimationDriver()
+    : m_easing(QEasingCurve::InOutQuad)
+    , m_lastTick(0)
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout,
+            this, &AnimationDriver::tick);
+}
+
+void AnimationDriver::start(const QObject *owner, KDecoration2::Decoration *decoration,
+                            bool forward, int duration, const Step &step)
+{
+    auto it = m_transitions.find(owner);
+    if (it == m_transitions.end()) {
+        Transition transition;
+        transition.progress = forward ? 0 : 1;
+        it = m_transitions.insert(owner, transition);
+
+        connect(owner, &QObject::destroyed,
+                this, &AnimationDriver::forget, Qt::UniqueConnection);
+        connect(decoration, &QObject::destroyed,
+                this, &AnimationDriver::forget, Qt::UniqueConnection);
+    }
+    it->decoration = decoration;
+    it->step = step;
+    it->duration = duration;
+    it->forward = forward;
+
+    if (!m_timer.isActive()) {
+        m_clock.start();
+        m_lastTick = 0;
+        m_timer.start(frameInterval());
+    }
+}
+
+void AnimationDriver::stop(const QObject *owner)
+{
+    m_transitions.remove(owner);
+    if (m_transitions.isEmpty()) {
+        m_timer.stop();
+    }
+}
+
+bool AnimationDriver::isRunning(const QObject *owner) const
+{
+    return m_transitions.contains(owner);
+}
+
+void AnimationDriver::tick()
+{
+    const qint64 now = m_clock.elapsed();
+    const qint64 elapsed = now - m_lastTick;
+    m_lastTick = now;
+
+    // Steps may start or stop transitions, their own included, so walk a
+    // snapshot of the owners and look every transition up again after
+    // its step ran.
+    m_ticking.clear();
+    for (auto it = m_transitions.constBegin(); it != m_transitions.constEnd(); ++it) {
+        m_ticking.append(it.key());
+    }
+
+    for (const QObject *owner : qAsConst(m_ticking)) {
+        auto it = m_transitions.find(owner);
+        if (it == m_transitions.end()) {
+            continue;
+        }
+
+        Transition &transition = it.value();
+        const qreal delta = transition.duration > 0 ? qreal(elapsed) / transition.duration : 1;
+        transition.progress = qBound<qreal>(0, transition.progress + (transition.forward ? delta : -delta), 1);
+
+        KDecoration2::Decoration *decoration = transition.decoration;
+        const Step step = transition.step;
+        const QRect damage = step(m_easing.valueForProgress(transition.progress));
+
+        it = m_transitions.find(owner);
+        if (it == m_transitions.end()) {
+            continue;
+        }
+        if (!damage.isEmpty() && it->decoration == decoration) {
+            m_damage[decoration] |= damage;
+        }
+
+        const bool finished = it->forward ? it->progress >= 1 : it->progress <= 0;
+        if (finished) {
+            m_transitions.erase(it);
+        }
+    }
+    m_ticking.clear();
+
+    for (auto it = m_damage.constBegin(); it != m_damage.constEnd(); ++it) {
+        it.key()->update(it.value());
+    }
+    m_damage.clear();
+
+    if (m_transitions.isEmpty()) {
+        m_timer.stop();
+    }
+}
+
+void AnimationDriver::forget(QObject *object)
+{
+    for (auto it = m_transitions.begin(); it != m_transitions.end();) {
+        if (it.key() == object || it->decoration == object) {
+            it = m_transitions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_damage.begin(); it != m_damage.end();) {
+        if (it.key() == object) {
+            it = m_damage.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (m_transitions.isEmpty()) {
+        m_timer.stop();
+    }
+}
+
+int AnimationDriver::frameInterval()
+{
+    const QScreen *screen = QGuiApplication::primaryScreen();
+    const qreal refreshRate = screen ? qMax<qreal>(screen->refreshRate(), 1) : 60;
+    return qMax(1, qCeil(1000 / refreshRate));
+}
+
+} // namespace Material
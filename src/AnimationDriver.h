@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QEasingCurve>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QRect>
+#include <QTimer>
+#include <QVector>
+
+// std
+#include <functional>
+
+namespace KDecoration2
+{
+class Decoration;
+}
+
+namespace Material
+{
+
+// Process-wide driver for button and menu transitions. Transitions are
+// plain entries that only exist while they run, all of them advance on
+// one timer that fires once per frame, and every decoration gets a
+// single repaint per tick for the area its transitions touched.
+// Transitions are dropped when their owner or decoration is destroyed.
+class AnimationDriver : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Receives the eased value and returns the part of the decoration
+    // that needs a repaint, instead of repainting it itself. It may start
+    // or stop transitions, new ones first advance on the next tick.
+    using Step = std::function<QRect(qreal value)>;
+
+    static AnimationDriver &self();
+
+    // Runs the transition of `owner` towards 1, or towards 0 if `forward`
+    // is false. A transition that is already running turns around where
+    // it is, a new one starts from the opposite end.
+    void start(const QObject *owner, KDecoration2::Decoration *decoration,
+               bool forward, int duration, const Step &step);
+    void stop(const QObject *owner);
+    bool isRunning(const QObject *owner) const;
+
+    // One frame of the primary screen in milliseconds, rounded up so a
+    // timer with this interval never fires twice in the same frame.
+    static int frameInterval();
+
+private Q_SLOTS:
+    void tick();
+    void forget(QObject *object);
+
+private:
+    AnimationDriver();
+
+    struct Transition
+    {
+        KDecoration2::Decoration *decoration = nullptr;
+        Step step;
+        int duration = 0;
+        bool forward = true;
+        qreal progress = 0; // linear, before easing
+    };
+
+    QHash<const QObject *, Transition> m_transitions;
+    QVector<const QObject *> m_ticking; // owners stepped by the current tick
+    QHash<KDecoration2::Decoration *, QRect> m_damage;
+    QEasingCurve m_easing;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_lastTick;
+};
+
+} // namespace Material
@@ -27,9 +27,6 @@
 // KDecoration
 #include <KDecoration2/DecoratedClient>
 
-// KF
-#include <KColorUtils>
-
 // Qt
 #include <QDebug>
 #include <QMouseEvent>
@@ -87,10 +84,9 @@ QColor AppMenuButton::foregroundColor() const
         if (!deco) {
             return {};
         }
-        return KColorUtils::mix(
-            deco->titleBarBackgroundColor(),
-            deco->titleBarForegroundColor(),
-            0.8);
+        const QRgb color = deco->buttonColors().foreground
+            [Decoration::NormalButtonKind][Decoration::NormalButtonState];
+        return QColor::fromRgba(qUnpremultiply(color));
     } else {
         return Button::foregroundColor();
     }
@@ -20,6 +20,7 @@
 // own
 #include "AppMenuButtonGroup.h"
 #include "Material.h"
+#include "AnimationDriver.h"
 #include "AppMenuModel.h"
 #include "Decoration.h"
 #include "AppMenuButton.h"
@@ -36,7 +37,6 @@
 #include <QDebug>
 #include <QMenu>
 #include <QPainter>
-#include <QVariantAnimation>
 
 
 namespace Material
@@ -50,7 +50,7 @@ AppMenuButtonGroup::AppMenuButtonGroup(Decoration *decoration)
     , m_hovered(false)
     , m_alwaysShow(true)
     , m_animationEnabled(false)
-    , m_animation(new QVariantAnimation(this))
+    , m_animationDuration(0)
     , m_opacity(1)
 {
     connect(this, &AppMenuButtonGroup::hoveredChanged, this,
@@ -64,13 +64,7 @@ AppMenuButtonGroup::AppMenuButtonGroup(Decoration *decoration)
             this, &AppMenuButtonGroup::updateOpacity);
 
     m_animationEnabled = decoration->animationsEnabled();
-    m_animation->setDuration(decoration->animationsDuration());
-    m_animation->setStartValue(0.0);
-    m_animation->setEndValue(1.0);
-    m_animation->setEasingCurve(QEasingCurve::InOutQuad);
-    connect(m_animation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
-        setOpacity(value.toReal());
-    });
+    m_animationDuration = decoration->animationsDuration();
     connect(this, &AppMenuButtonGroup::opacityChanged, this, [this]() {
         // update();
     });
@@ -86,6 +80,7 @@ AppMenuButtonGroup::AppMenuButtonGroup(Decoration *decoration)
 
 AppMenuButtonGroup::~AppMenuButtonGroup()
 {
+    AnimationDriver::self().stop(this);
 }
 
 int AppMenuButtonGroup::currentIndex() const
@@ -159,13 +154,13 @@ void AppMenuButtonGroup::setAnimationEnabled(bool value)
 
 int AppMenuButtonGroup::animationDuration() const
 {
-    return m_animation->duration();
+    return m_animationDuration;
 }
 
 void AppMenuButtonGroup::setAnimationDuration(int value)
 {
-    if (m_animation->duration() != value) {
-        m_animation->setDuration(value);
+    if (m_animationDuration != value) {
+        m_animationDuration = value;
         emit animationDurationChanged(value);
     }
 }
@@ -177,19 +172,31 @@ qreal AppMenuButtonGroup::opacity() const
 
 void AppMenuButtonGroup::setOpacity(qreal value)
 {
-    if (m_opacity != value) {
-        m_opacity = value;
-
-        for (int i = 0; i < buttons().length(); i++) {
-            KDecoration2::DecorationButton* decoButton = buttons().value(i);
-            auto *button = qobject_cast<Button *>(decoButton);
-            if (button) {
-                button->setOpacity(m_opacity);
-            }
+    if (applyOpacity(value)) {
+        auto *deco = qobject_cast<Decoration *>(decoration());
+        if (deco) {
+            deco->update(deco->menuFadeRect());
         }
+    }
+}
 
-        emit opacityChanged(value);
+bool AppMenuButtonGroup::applyOpacity(qreal value)
+{
+    if (m_opacity == value) {
+        return false;
     }
+    m_opacity = value;
+
+    for (int i = 0; i < buttons().length(); i++) {
+        KDecoration2::DecorationButton* decoButton = buttons().value(i);
+        auto *button = qobject_cast<Button *>(decoButton);
+        if (button) {
+            button->applyOpacity(m_opacity);
+        }
+    }
+
+    emit opacityChanged(value);
+    return true;
 }
 
 KDecoration2::DecorationButton* AppMenuButtonGroup::buttonAt(int x, int y) const
@@ -517,18 +524,19 @@ void AppMenuButtonGroup::onMenuAboutToHide()
 void AppMenuButtonGroup::onHoveredChanged(bool hovered)
 {
     if (m_alwaysShow) {
+        AnimationDriver::self().stop(this);
         setOpacity(1);
     } else {
         if (m_animationEnabled) {
-            QAbstractAnimation::Direction dir = hovered ? QAbstractAnimation::Forward : QAbstractAnimation::Backward;
-            if (m_animation->state() == QAbstractAnimation::Running && m_animation->direction() != dir) {
-                m_animation->stop();
-            }
-            m_animation->setDirection(dir);
-            if (m_animation->state() != QAbstractAnimation::Running) {
-                m_animation->start();
-            }
+            // The driver repaints the menu and the caption once per tick.
+            AnimationDriver::self().start(this, decoration().data(), hovered, m_animationDuration,
+                [this](qreal value) {
+                    applyOpacity(value);
+                    const auto *deco = qobject_cast<Decoration *>(decoration());
+                    return deco ? deco->menuFadeRect() : QRect();
+                });
         } else {
+            AnimationDriver::self().stop(this);
             setOpacity(hovered ? 1 : 0);
         }
     }
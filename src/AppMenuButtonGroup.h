@@ -27,7 +27,6 @@
 
 // Qt
 #include <QMenu>
-#include <QVariantAnimation>
 
 namespace Material
 {
@@ -70,6 +69,8 @@ public:
 
     qreal opacity() const;
     void setOpacity(qreal value);
+    // Like setOpacity(), but leaves the repaint to the caller.
+    bool applyOpacity(qreal value);
 
     KDecoration2::DecorationButton* buttonAt(int x, int y) const;
 
@@ -112,7 +113,7 @@ private:
     bool m_hovered;
     bool m_alwaysShow;
     bool m_animationEnabled;
-    QVariantAnimation *m_animation;
+    int m_animationDuration;
     qreal m_opacity;
     QPointer<QMenu> m_currentMenu;
 };
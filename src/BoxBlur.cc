@@ -0,0 +1,458 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "BoxBlur.h"
+
+// std
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATERIAL_BOXBLUR_X86 1
+#include <immintrin.h>
+#define MATERIAL_TARGET_SSE2 __attribute__((target("sse2")))
+#define MATERIAL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MATERIAL_BOXBLUR_X86 0
+#endif
+
+
+namespace Material
+{
+namespace BoxBlur
+{
+
+namespace
+{
+
+inline int boxSizeToRadius(int boxSize)
+{
+    return (boxSize - 1) / 2;
+}
+
+// Reference implementation. The SIMD kernels below must produce exactly
+// the same bytes, including the truncation of `window * invSize`.
+void runScalar(const Pass &pass, int firstRow, int lastRow)
+{
+    const int srcStep = pass.srcPixelStride;
+    const int dstStep = pass.dstBytesPerLine;
+
+    const int radius = boxSizeToRadius(pass.boxSize);
+    const qreal invSize = 1.0 / pass.boxSize;
+
+    for (int y = firstRow; y < lastRow; ++y) {
+        const uchar *srcAlpha = pass.src + y * pass.srcBytesPerLine;
+        uchar *dstAlpha = pass.dst + y * pass.dstPixelStride;
+
+        const uchar *left = srcAlpha;
+        const uchar *right = left + srcStep * radius;
+
+        int window = 0;
+        for (int x = 0; x < radius; ++x) {
+            window += *srcAlpha;
+            srcAlpha += srcStep;
+        }
+
+        for (int x = 0; x <= radius; ++x) {
+            window += *right;
+            right += srcStep;
+            *dstAlpha = static_cast<uchar>(window * invSize);
+            dstAlpha += dstStep;
+        }
+
+        for (int x = radius + 1; x < pass.width - radius; ++x) {
+            window += *right - *left;
+            left += srcStep;
+            right += srcStep;
+            *dstAlpha = static_cast<uchar>(window * invSize);
+            dstAlpha += dstStep;
+        }
+
+        for (int x = pass.width - radius; x < pass.width; ++x) {
+            window -= *left;
+            left += srcStep;
+            *dstAlpha = static_cast<uchar>(window * invSize);
+            dstAlpha += dstStep;
+        }
+    }
+}
+
+#if MATERIAL_BOXBLUR_X86
+
+// The SIMD kernels divide by the box size with a 32.32 fixed-point
+// multiply: floor(window * m / 2^32) with m = floor(2^32 / boxSize) + 1.
+// That is the exact quotient as long as window * boxSize < 2^32, which
+// holds for window <= 255 * boxSize and boxSize < 4096.
+inline quint32 divisorMultiplier(int boxSize)
+{
+    return static_cast<quint32>((Q_UINT64_C(1) << 32) / boxSize + 1);
+}
+
+// The reference kernel multiplies by a rounded reciprocal, which for a few
+// box sizes (49, 98, 103, ...) truncates k * boxSize down to k - 1. Only
+// exact multiples can be affected, so checking those is enough to know
+// whether the exact quotient matches byte for byte.
+bool exactQuotientMatchesReference(int boxSize)
+{
+    const qreal invSize = 1.0 / boxSize;
+    for (int k = 1; k <= 255; ++k) {
+        if (static_cast<uchar>(k * boxSize * invSize) != k) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool simdCompatible(const Pass &pass)
+{
+    return pass.boxSize >= 2
+        && pass.boxSize < 4096
+        && pass.width >= pass.boxSize
+        && exactQuotientMatchesReference(pass.boxSize);
+}
+
+inline void storeLanes(const uchar *lanes, int count, uchar *dst, int step)
+{
+    for (int i = 0; i < count; ++i) {
+        dst[i * step] = lanes[i];
+    }
+}
+
+//--- SSE2: four source rows per iteration, one per 32-bit lane.
+MATERIAL_TARGET_SSE2
+inline __m128i loadSse2(const uchar *const *rows, int offset)
+{
+    return _mm_setr_epi32(rows[0][offset], rows[1][offset], rows[2][offset], rows[3][offset]);
+}
+
+// Loads four consecutive samples from each of four tightly packed rows
+// and transposes them, so that column i ends up in cols[i].
+MATERIAL_TARGET_SSE2
+inline __m128i loadQuadSse2(const uchar *const *rows, int offset)
+{
+    quint32 words[4];
+    for (int i = 0; i < 4; ++i) {
+        std::memcpy(&words[i], rows[i] + offset, sizeof(quint32));
+    }
+    const __m128i ab = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(words[0])), _mm_cvtsi32_si128(static_cast<int>(words[1])));
+    const __m128i cd = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(words[2])), _mm_cvtsi32_si128(static_cast<int>(words[3])));
+    return _mm_unpacklo_epi16(ab, cd);
+}
+
+MATERIAL_TARGET_SSE2
+inline void unpackQuadSse2(__m128i quad, __m128i *cols)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_unpacklo_epi8(quad, zero);
+    const __m128i hi = _mm_unpackhi_epi8(quad, zero);
+    cols[0] = _mm_unpacklo_epi16(lo, zero);
+    cols[1] = _mm_unpackhi_epi16(lo, zero);
+    cols[2] = _mm_unpacklo_epi16(hi, zero);
+    cols[3] = _mm_unpackhi_epi16(hi, zero);
+}
+
+MATERIAL_TARGET_SSE2
+inline __m128i divideSse2(__m128i window, __m128i multiplier)
+{
+    const __m128i even = _mm_srli_epi64(_mm_mul_epu32(window, multiplier), 32);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(window, 32), multiplier);
+    return _mm_or_si128(even, _mm_and_si128(odd, _mm_set_epi32(-1, 0, -1, 0)));
+}
+
+MATERIAL_TARGET_SSE2
+inline void storeSse2(__m128i window, __m128i multiplier, uchar *dst, int step)
+{
+    const __m128i quotient = divideSse2(window, multiplier);
+    const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(quotient, quotient), _mm_setzero_si128());
+
+    if (step == 1) {
+        const int bytes = _mm_cvtsi128_si32(packed);
+        std::memcpy(dst, &bytes, sizeof(bytes));
+        return;
+    }
+
+    alignas(16) uchar lanes[16];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), packed);
+    storeLanes(lanes, 4, dst, step);
+}
+
+MATERIAL_TARGET_SSE2
+int runSse2(const Pass &pass, int firstRow, int lastRow)
+{
+    const int lanes = 4;
+    const int srcStep = pass.srcPixelStride;
+    const int dstStep = pass.dstBytesPerLine;
+
+    const int radius = boxSizeToRadius(pass.boxSize);
+    const __m128i multiplier = _mm_set1_epi32(static_cast<int>(divisorMultiplier(pass.boxSize)));
+
+    int y = firstRow;
+    for (; y + lanes <= lastRow; y += lanes) {
+        const uchar *rows[lanes];
+        for (int i = 0; i < lanes; ++i) {
+            rows[i] = pass.src + (y + i) * pass.srcBytesPerLine;
+        }
+        uchar *dstAlpha = pass.dst + y * pass.dstPixelStride;
+
+        int left = 0;
+        int right = srcStep * radius;
+
+        __m128i window = _mm_setzero_si128();
+        for (int x = 0; x < radius; ++x) {
+            window = _mm_add_epi32(window, loadSse2(rows, x * srcStep));
+        }
+
+        for (int x = 0; x <= radius; ++x) {
+            window = _mm_add_epi32(window, loadSse2(rows, right));
+            right += srcStep;
+            storeSse2(window, multiplier, dstAlpha, pass.dstPixelStride);
+            dstAlpha += dstStep;
+        }
+
+        int x = radius + 1;
+        if (srcStep == 1) {
+            for (; x + 4 <= pass.width - radius; x += 4) {
+                __m128i added[4];
+                __m128i removed[4];
+                unpackQuadSse2(loadQuadSse2(rows, right), added);
+                unpackQuadSse2(loadQuadSse2(rows, left), removed);
+                for (int i = 0; i < 4; ++i) {
+                    window = _mm_sub_epi32(_mm_add_epi32(window, added[i]), removed[i]);
+                    storeSse2(window, multiplier, dstAlpha, pass.dstPixelStride);
+                    dstAlpha += dstStep;
+                }
+                left += 4;
+                right += 4;
+            }
+        }
+
+        for (; x < pass.width - radius; ++x) {
+            window = _mm_add_epi32(window, loadSse2(rows, right));
+            window = _mm_sub_epi32(window, loadSse2(rows, left));
+            left += srcStep;
+            right += srcStep;
+            storeSse2(window, multiplier, dstAlpha, pass.dstPixelStride);
+            dstAlpha += dstStep;
+        }
+
+        for (int x = pass.width - radius; x < pass.width; ++x) {
+            window = _mm_sub_epi32(window, loadSse2(rows, left));
+            left += srcStep;
+            storeSse2(window, multiplier, dstAlpha, pass.dstPixelStride);
+            dstAlpha += dstStep;
+        }
+    }
+
+    return y;
+}
+
+//--- AVX2: eight source rows per iteration, one per 32-bit lane.
+MATERIAL_TARGET_AVX2
+inline __m256i loadAvx2(const uchar *const *rows, int offset)
+{
+    return _mm256_setr_epi32(
+        rows[0][offset], rows[1][offset], rows[2][offset], rows[3][offset],
+        rows[4][offset], rows[5][offset], rows[6][offset], rows[7][offset]);
+}
+
+// Same as loadQuadSse2(), for eight rows. Each of the four columns is
+// returned as eight bytes, ready to be widened with vpmovzxbd.
+MATERIAL_TARGET_AVX2
+inline void loadQuadAvx2(const uchar *const *rows, int offset, __m256i *cols)
+{
+    const __m128i upper = loadQuadSse2(rows, offset);
+    const __m128i lower = loadQuadSse2(rows + 4, offset);
+    const __m128i cols01 = _mm_unpacklo_epi32(upper, lower);
+    const __m128i cols23 = _mm_unpackhi_epi32(upper, lower);
+    cols[0] = _mm256_cvtepu8_epi32(cols01);
+    cols[1] = _mm256_cvtepu8_epi32(_mm_srli_si128(cols01, 8));
+    cols[2] = _mm256_cvtepu8_epi32(cols23);
+    cols[3] = _mm256_cvtepu8_epi32(_mm_srli_si128(cols23, 8));
+}
+
+MATERIAL_TARGET_AVX2
+inline __m256i divideAvx2(__m256i window, __m256i multiplier)
+{
+    const __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(window, multiplier), 32);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(window, 32), multiplier);
+    return _mm256_or_si256(even, _mm256_and_si256(odd, _mm256_set_epi32(-1, 0, -1, 0, -1, 0, -1, 0)));
+}
+
+MATERIAL_TARGET_AVX2
+inline void storeAvx2(__m256i window, __m256i multiplier, uchar *dst, int step)
+{
+    const __m256i quotient = divideAvx2(window, multiplier);
+    const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(quotient), _mm256_extracti128_si256(quotient, 1));
+    const __m128i packed = _mm_packus_epi16(words, _mm_setzero_si128());
+
+    if (step == 1) {
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), packed);
+        return;
+    }
+
+    alignas(16) uchar lanes[16];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), packed);
+    storeLanes(lanes, 8, dst, step);
+}
+
+MATERIAL_TARGET_AVX2
+int runAvx2(const Pass &pass, int firstRow, int lastRow)
+{
+    const int lanes = 8;
+    const int srcStep = pass.srcPixelStride;
+    const int dstStep = pass.dstBytesPerLine;
+
+    const int radius = boxSizeToRadius(pass.boxSize);
+    const __m256i multiplier = _mm256_set1_epi32(static_cast<int>(divisorMultiplier(pass.boxSize)));
+
+    int y = firstRow;
+    for (; y + lanes <= lastRow; y += lanes) {
+        const uchar *rows[lanes];
+        for (int i = 0; i < lanes; ++i) {
+            rows[i] = pass.src + (y + i) * pass.srcBytesPerLine;
+        }
+        uchar *dstAlpha = pass.dst + y * pass.dstPixelStride;
+
+        int left = 0;
+        int right = srcStep * radius;
+
+        __m256i window = _mm256_setzero_si256();
+        for (int x = 0; x < radius; ++x) {
+            window = _mm256_add_epi32(window, loadAvx2(rows, x * srcStep));
+        }
+
+        for (int x = 0; x <= radius; ++x) {
+            window = _mm256_add_epi32(window, loadAvx2(rows, right));
+            right += srcStep;
+            storeAvx2(window, multiplier, dstAlpha, pass.dstPixelStride);
+            dstAlpha += dstStep;
+        }
+
+        int x = radius + 1;
+        if (srcStep == 1) {
+            for (; x + 4 <= pass.width - radius; x += 4) {
+                __m256i added[4];
+                __m256i removed[4];
+                loadQuadAvx2(rows, right, added);
+                loadQuadAvx2(rows, left, removed);
+                for (int i = 0; i < 4; ++i) {
+                    window = _mm256_sub_epi32(_mm256_add_epi32(window, added[i]), removed[i]);
+                    storeAvx2(window, multiplier, dstAlpha, pass.dstPixelStride);
+                    dstAlpha += dstStep;
+                }
+                left += 4;
+                right += 4;
+            }
+        }
+
+        for (; x < pass.width - radius; ++x) {
+            window = _mm256_add_epi32(window, loadAvx2(rows, right));
+            window = _mm256_sub_epi32(window, loadAvx2(rows, left));
+            left += srcStep;
+            right += srcStep;
+            storeAvx2(window, multiplier, dstAlpha, pass.dstPixelStride);
+            dstAlpha += dstStep;
+        }
+
+        for (int x = pass.width - radius; x < pass.width; ++x) {
+            window = _mm256_sub_epi32(window, loadAvx2(rows, left));
+            left += srcStep;
+            storeAvx2(window, multiplier, dstAlpha, pass.dstPixelStride);
+            dstAlpha += dstStep;
+        }
+    }
+
+    // Leftover rows still get four lanes at a time.
+    return runSse2(pass, y, lastRow);
+}
+
+#endif // MATERIAL_BOXBLUR_X86
+
+} // anonymous namespace
+
+Backend preferredBackend()
+{
+#if MATERIAL_BOXBLUR_X86
+    static const Backend backend = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return Backend::AVX2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return Backend::SSE2;
+        }
+        return Backend::Scalar;
+    }();
+    return backend;
+#else
+    return Backend::Scalar;
+#endif
+}
+
+const char *backendName(Backend backend)
+{
+    switch (backend) {
+    case Backend::AVX2:
+        return "AVX2";
+    case Backend::SSE2:
+        return "SSE2";
+    default:
+    case Backend::Scalar:
+        return "Scalar";
+    }
+}
+
+void run(const Pass &pass)
+{
+    run(pass, preferredBackend());
+}
+
+void run(const Pass &pass, Backend backend)
+{
+    if (pass.width <= 0 || pass.height <= 0) {
+        return;
+    }
+
+    int row = 0;
+
+#if MATERIAL_BOXBLUR_X86
+    // Never run code the CPU doesn't support, even if asked to.
+    if (backend > preferredBackend()) {
+        backend = preferredBackend();
+    }
+
+    if (backend != Backend::Scalar && simdCompatible(pass)) {
+        switch (backend) {
+        case Backend::AVX2:
+            row = runAvx2(pass, 0, pass.height);
+            break;
+        case Backend::SSE2:
+            row = runSse2(pass, 0, pass.height);
+            break;
+        default:
+            break;
+        }
+    }
+#else
+    Q_UNUSED(backend)
+#endif
+
+    runScalar(pass, row, pass.height);
+}
+
+} // namespace BoxBlur
+} // namespace Material
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QtGlobal>
+
+namespace Material
+{
+namespace BoxBlur
+{
+
+enum class Backend {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+// One horizontal box blur pass over 8-bit samples. Every source row is
+// blurred and written transposed, so source row y becomes destination
+// column y. Samples don't need to be tightly packed, which lets the
+// kernel work directly on the alpha byte of an ARGB32 image.
+struct Pass
+{
+    const uchar *src = nullptr; // first sample of the first source row
+    int srcBytesPerLine = 0;
+    int srcPixelStride = 1;     // bytes between two source samples
+
+    uchar *dst = nullptr;       // first sample of the first destination row
+    int dstBytesPerLine = 0;
+    int dstPixelStride = 1;     // bytes between two destination samples
+
+    int width = 0;              // samples per source row
+    int height = 0;             // number of source rows
+    int boxSize = 1;
+};
+
+// Fastest backend supported by the CPU we're running on.
+Backend preferredBackend();
+const char *backendName(Backend backend);
+
+void run(const Pass &pass);
+void run(const Pass &pass, Backend backend);
+
+} // namespace BoxBlur
+} // namespace Material
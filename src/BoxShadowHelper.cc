@@ -17,12 +17,18 @@
 
 // own
 #include "BoxShadowHelper.h"
+#include "BoxBlur.h"
+#include "ScratchArena.h"
 
 // Qt
+#include <QVarLengthArray>
 #include <QVector>
+#include <QtMath> // M_SQRT2, qCeil
 
 // std
 #include <cmath>
+#include <cstring>
+#include <utility> // std::swap
 
 
 namespace Material
@@ -38,7 +44,22 @@ namespace
 // As a workaround, sigma blur scale is lowered. With the lowered sigma
 // blur scale, area under the kernel equals to 0.98, which is pretty enough.
 // Maybe, it should be changed in the future.
-const qreal SIGMA_BLUR_SCALE = 0.4375;
+constexpr qreal SIGMA_BLUR_SCALE = 0.4375;
+static_assert(SIGMA_BLUR_SCALE * 16 == 7, "boxSize() assumes a sigma of 7/16 of the radius");
+
+// The presets' radii at 1x.
+static_assert(boxSize(8, 0) == 7 && boxSize(8, 2) == 7, "Small, contrast");
+static_assert(boxSize(16, 1) == 13 && boxSize(16, 2) == 15, "Small, shape");
+static_assert(boxSize(32, 1) == 27 && boxSize(32, 2) == 29, "Medium, shape");
+static_assert(boxSize(48, 1) == 41 && boxSize(48, 2) == 43, "Large, shape");
+static_assert(boxSize(64, 1) == 55 && boxSize(64, 2) == 57, "Very large, shape");
+
+// The scale the spec asks for, used by ShadowGenerator::ExactGaussian.
+const qreal EXACT_SIGMA_BLUR_SCALE = 0.5;
+
+// A Gaussian is down to 0.1% of its peak three sigmas out.
+const qreal GAUSSIAN_KERNEL_EXTENT = 3;
+
 } // anonymous namespace
 
 inline qreal radiusToSigma(qreal radius)
@@ -46,13 +67,20 @@ inline qreal radiusToSigma(qreal radius)
     return radius * SIGMA_BLUR_SCALE;
 }
 
-inline int boxSizeToRadius(int boxSize)
+int shadowExtent(int radius, ShadowGenerator generator)
 {
-    return (boxSize - 1) / 2;
+    if (generator == ShadowGenerator::ExactGaussian) {
+        return qCeil(radius * EXACT_SIGMA_BLUR_SCALE * GAUSSIAN_KERNEL_EXTENT);
+    }
+    return radius;
 }
 
 QVector<int> computeBoxSizes(int radius, int numIterations)
 {
+    if (numIterations == 3) {
+        return { boxSize(radius, 0), boxSize(radius, 1), boxSize(radius, 2) };
+    }
+
     const qreal sigma = radiusToSigma(radius);
 
     // Box sizes are computed according to the "Fast Almost-Gaussian Filtering"
@@ -75,98 +103,461 @@ QVector<int> computeBoxSizes(int radius, int numIterations)
     return boxSizes;
 }
 
+inline int alphaOffset(const QImage &image)
+{
+    if (image.format() == QImage::Format_Alpha8) {
+        return 0;
+    }
+    return QSysInfo::ByteOrder == QSysInfo::BigEndian ? 0 : 3;
+}
+
+// Same rounding as Qt's BYTE_MUL, so tinting a plane gives exactly what
+// filling it with CompositionMode_SourceIn used to give.
+inline QRgb multiplyAlpha(QRgb premultiplied, uint alpha)
+{
+    quint32 rb = (premultiplied & 0xff00ff) * alpha;
+    rb = (rb + ((rb >> 8) & 0xff00ff) + 0x800080) >> 8;
+    rb &= 0xff00ff;
+
+    quint32 ag = ((premultiplied >> 8) & 0xff00ff) * alpha;
+    ag = ag + ((ag >> 8) & 0xff00ff) + 0x800080;
+    ag &= 0xff00ff00;
+
+    return ag | rb;
+}
+
 void boxBlurPass(const QImage &src, QImage &dst, int boxSize)
 {
     const int alphaStride = src.depth() >> 3;
-    const int alphaOffset = QSysInfo::ByteOrder == QSysInfo::BigEndian ? 0 : 3;
 
-    const int radius = boxSizeToRadius(boxSize);
-    const qreal invSize = 1.0 / boxSize;
+    BoxBlur::Pass pass;
+    pass.src = src.constBits() + alphaOffset(src);
+    pass.srcBytesPerLine = src.bytesPerLine();
+    pass.srcPixelStride = alphaStride;
+    pass.dst = dst.bits() + alphaOffset(dst);
+    pass.dstBytesPerLine = dst.bytesPerLine();
+    pass.dstPixelStride = dst.depth() >> 3;
+    pass.width = src.width();
+    pass.height = src.height();
+    pass.boxSize = boxSize;
+
+    BoxBlur::run(pass);
+}
+
+void boxBlurAlpha(QImage &image, int radius, int numIterations)
+{
+    // Temporary buffer is transposed so we always read memory
+    // in linear order. Rows are 4-byte aligned, like QImage's own.
+    const int bytesPerLine = (image.height() * image.depth() / 8 + 3) & ~3;
+    uchar *bits = ScratchArena::local().buffer(ScratchArena::Transposed, size_t(bytesPerLine) * image.width());
+    QImage tmp(bits, image.height(), image.width(), bytesPerLine, image.format());
+
+    const QVector<int> boxSizes = computeBoxSizes(radius, numIterations);
+    for (const int &boxSize : boxSizes) {
+        boxBlurPass(image, tmp, boxSize); // horizontal pass
+        boxBlurPass(tmp, image, boxSize); // vertical pass
+    }
+}
 
-    const int dstStride = dst.width() * alphaStride;
+QImage tintAlpha(const QImage &alpha, const QColor &color)
+{
+    QImage tinted(alpha.size(), QImage::Format_ARGB32_Premultiplied);
+    tinted.setDevicePixelRatio(alpha.devicePixelRatioF());
+
+    const QRgb premultiplied = qPremultiply(color.rgba());
+    for (int y = 0; y < alpha.height(); ++y) {
+        const uchar *src = alpha.constScanLine(y);
+        QRgb *dst = reinterpret_cast<QRgb *>(tinted.scanLine(y));
+        for (int x = 0; x < alpha.width(); ++x) {
+            dst[x] = multiplyAlpha(premultiplied, src[x]);
+        }
+    }
 
-    for (int y = 0; y < src.height(); ++y) {
-        const uchar *srcAlpha = src.scanLine(y);
-        uchar *dstAlpha = dst.scanLine(0);
+    return tinted;
+}
 
-        srcAlpha += alphaOffset;
-        dstAlpha += alphaOffset + y * alphaStride;
+// A step that is 1 on [begin, end) and 0 elsewhere, blurred with the same
+// three box filters as boxBlurAlpha(), into `profile`. Samples outside the
+// line count as 0, just like they do in the 2-D kernel.
+void boxBlurredStep(qreal *profile, int length, int begin, int end, int radius)
+{
+    for (int x = 0; x < length; ++x) {
+        profile[x] = (begin <= x && x < end) ? 1 : 0;
+    }
 
-        const uchar *left = srcAlpha;
-        const uchar *right = left + alphaStride * radius;
+    qreal *src = profile;
+    qreal *dst = ScratchArena::local().buffer<qreal>(ScratchArena::Temporary, length);
+    for (int pass = 0; pass < 3; ++pass) {
+        const int size = boxSize(radius, pass);
+        const int halfSize = (size - 1) / 2;
+        const qreal invSize = 1.0 / size;
 
-        int window = 0;
-        for (int x = 0; x < radius; ++x) {
-            window += *srcAlpha;
-            srcAlpha += alphaStride;
+        qreal window = 0;
+        for (int i = 0; i < qMin(halfSize, length); ++i) {
+            window += src[i];
         }
 
-        for (int x = 0; x <= radius; ++x) {
-            window += *right;
-            right += alphaStride;
-            *dstAlpha = static_cast<uchar>(window * invSize);
-            dstAlpha += dstStride;
+        for (int x = 0; x < length; ++x) {
+            if (x + halfSize < length) {
+                window += src[x + halfSize];
+            }
+            if (x - halfSize - 1 >= 0) {
+                window -= src[x - halfSize - 1];
+            }
+            dst[x] = window * invSize;
         }
 
-        for (int x = radius + 1; x < src.width() - radius; ++x) {
-            window += *right - *left;
-            left += alphaStride;
-            right += alphaStride;
-            *dstAlpha = static_cast<uchar>(window * invSize);
-            dstAlpha += dstStride;
-        }
+        std::swap(src, dst);
+    }
 
-        for (int x = src.width() - radius; x < src.width(); ++x) {
-            window -= *left;
-            left += alphaStride;
-            *dstAlpha = static_cast<uchar>(window * invSize);
-            dstAlpha += dstStride;
+    if (src != profile) {
+        std::memcpy(profile, src, length * sizeof(qreal));
+    }
+}
+
+// The same step convolved with a Gaussian, sampled at pixel centers.
+void gaussianBlurredStep(qreal *profile, int length, int begin, int end, qreal sigma)
+{
+    if (sigma <= 0) {
+        for (int x = 0; x < length; ++x) {
+            profile[x] = (begin <= x && x < end) ? 1 : 0;
         }
+        return;
+    }
+
+    const qreal scale = 1.0 / (sigma * M_SQRT2);
+    for (int x = 0; x < length; ++x) {
+        const qreal center = x + 0.5;
+        profile[x] = 0.5 * (std::erf((center - begin) * scale) - std::erf((center - end) * scale));
     }
 }
 
-void boxBlurAlpha(QImage &image, int radius, int numIterations)
+// Normalized Gaussian kernel of 2 * halfWidth + 1 taps. Every tap holds
+// the integral of the Gaussian over its pixel, so narrow kernels keep
+// their area.
+const qreal *gaussianKernel(qreal sigma, int &halfWidth)
 {
-    // Temporary buffer is transposed so we always read memory
-    // in linear order.
-    QImage tmp(image.height(), image.width(), image.format());
+    halfWidth = qMax(0, qCeil(sigma * GAUSSIAN_KERNEL_EXTENT));
+    qreal *kernel = ScratchArena::local().buffer<qreal>(ScratchArena::Kernel, 2 * halfWidth + 1);
 
-    const QVector<int> boxSizes = computeBoxSizes(radius, numIterations);
-    for (const int &boxSize : boxSizes) {
-        boxBlurPass(image, tmp, boxSize); // horizontal pass
-        boxBlurPass(tmp, image, boxSize); // vertical pass
+    if (sigma <= 0) {
+        kernel[halfWidth] = 1;
+        return kernel;
+    }
+
+    const qreal scale = 1.0 / (sigma * M_SQRT2);
+    qreal sum = 0;
+    for (int i = -halfWidth; i <= halfWidth; ++i) {
+        const qreal weight = 0.5 * (std::erf((i + 0.5) * scale) - std::erf((i - 0.5) * scale));
+        kernel[i + halfWidth] = weight;
+        sum += weight;
+    }
+    for (int i = 0; i < 2 * halfWidth + 1; ++i) {
+        kernel[i] /= sum;
     }
+
+    return kernel;
 }
 
-void boxShadow(QPainter *p, const QRect &box, const QPoint &offset, int radius, const QColor &color)
+// The step convolved with `kernel`. Each sample is the sum of the taps
+// that land inside [begin, end), looked up in a prefix sum.
+void kernelBlurredStep(qreal *profile, int length, int begin, int end, const qreal *kernel, int halfWidth)
 {
-    const QSize size = box.size() + 2 * QSize(radius, radius);
-    const qreal dpr = p->device()->devicePixelRatioF();
+    const int taps = 2 * halfWidth + 1;
 
-    QPainter painter;
+    qreal *prefix = ScratchArena::local().buffer<qreal>(ScratchArena::Temporary, taps + 1);
+    prefix[0] = 0;
+    for (int i = 0; i < taps; ++i) {
+        prefix[i + 1] = prefix[i] + kernel[i];
+    }
 
-    QImage shadow(size * dpr, QImage::Format_ARGB32_Premultiplied);
-    shadow.setDevicePixelRatio(dpr);
-    shadow.fill(Qt::transparent);
+    for (int x = 0; x < length; ++x) {
+        const int first = qMax(begin - x, -halfWidth) + halfWidth;
+        const int last = qMin(end - 1 - x, halfWidth) + halfWidth;
+        profile[x] = first <= last ? prefix[last + 1] - prefix[first] : 0;
+    }
+}
 
-    painter.begin(&shadow);
-    painter.fillRect(QRect(QPoint(radius, radius), box.size()), Qt::black);
-    painter.end();
+// Fills an alpha plane with the outer product of two profiles. The row
+// weight is folded with the 8-bit range once per scanline, which leaves
+// one multiply per pixel.
+QImage separableAlpha(const qreal *columns, int width, const qreal *rows, int height)
+{
+    QImage alpha(width, height, QImage::Format_Alpha8);
+
+    // 12-bit column weights times 20-bit row weights still fit in 32 bits.
+    const int one = 1 << 12;
+    quint32 *columnWeights = ScratchArena::local().buffer<quint32>(ScratchArena::Weights, width);
+    for (int x = 0; x < width; ++x) {
+        columnWeights[x] = qBound(0, qRound(columns[x] * one), one);
+    }
+
+    for (int y = 0; y < height; ++y) {
+        const quint32 rowWeight = qBound(0, qRound(rows[y] * one * 255), one * 255);
+        uchar *line = alpha.scanLine(y);
+        for (int x = 0; x < width; ++x) {
+            line[x] = static_cast<uchar>((columnWeights[x] * rowWeight + (1u << 23)) >> 24);
+        }
+    }
+
+    return alpha;
+}
+
+QImage boxShadowAlpha(const QSize &box, int radius, qreal dpr, ShadowGenerator generator)
+{
+    const int extent = shadowExtent(radius, generator);
+    const QSize size = (box + 2 * QSize(extent, extent)) * dpr;
+
+    const int left = qRound(extent * dpr);
+    const int top = qRound(extent * dpr);
+    const int right = qMin(qRound((extent + box.width()) * dpr), size.width());
+    const int bottom = qMin(qRound((extent + box.height()) * dpr), size.height());
+
+    // The radius is in logical pixels, the plane is in device pixels.
+    const qreal deviceRadius = radius * dpr;
 
-    // There is no need to blur RGB channels. Blur the alpha
-    // channel and then give the shadow a tint of the desired color.
     const int numIterations = 3;
-    boxBlurAlpha(shadow, radius, numIterations);
+    QImage shadow;
+
+    // The profiles of the separable generators.
+    auto columns = [&size] {
+        return ScratchArena::local().buffer<qreal>(ScratchArena::Columns, size.width());
+    };
+    auto rows = [&size] {
+        return ScratchArena::local().buffer<qreal>(ScratchArena::Rows, size.height());
+    };
+
+    switch (generator) {
+    case ShadowGenerator::SeparableBox: {
+        qreal *columnProfile = columns();
+        qreal *rowProfile = rows();
+        boxBlurredStep(columnProfile, size.width(), left, right, qRound(deviceRadius));
+        boxBlurredStep(rowProfile, size.height(), top, bottom, qRound(deviceRadius));
+        shadow = separableAlpha(columnProfile, size.width(), rowProfile, size.height());
+        break;
+    }
 
-    painter.begin(&shadow);
-    painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
-    painter.fillRect(shadow.rect(), color);
-    painter.end();
+    case ShadowGenerator::SeparableGaussian: {
+        const qreal sigma = radiusToSigma(deviceRadius);
+        qreal *columnProfile = columns();
+        qreal *rowProfile = rows();
+        gaussianBlurredStep(columnProfile, size.width(), left, right, sigma);
+        gaussianBlurredStep(rowProfile, size.height(), top, bottom, sigma);
+        shadow = separableAlpha(columnProfile, size.width(), rowProfile, size.height());
+        break;
+    }
+
+    case ShadowGenerator::ExactGaussian: {
+        int halfWidth = 0;
+        const qreal *kernel = gaussianKernel(deviceRadius * EXACT_SIGMA_BLUR_SCALE, halfWidth);
+        qreal *columnProfile = columns();
+        qreal *rowProfile = rows();
+        kernelBlurredStep(columnProfile, size.width(), left, right, kernel, halfWidth);
+        kernelBlurredStep(rowProfile, size.height(), top, bottom, kernel, halfWidth);
+        shadow = separableAlpha(columnProfile, size.width(), rowProfile, size.height());
+        break;
+    }
+
+    default:
+    case ShadowGenerator::BoxBlur:
+        // There is no need to blur RGB channels. Blur a single alpha plane
+        // and then give the shadow a tint of the desired color.
+        shadow = QImage(size, QImage::Format_Alpha8);
+        shadow.fill(0);
+        for (int y = top; y < bottom && left < right; ++y) {
+            std::memset(shadow.scanLine(y) + left, 0xff, right - left);
+        }
+        boxBlurAlpha(shadow, qRound(deviceRadius), numIterations);
+        break;
+    }
+
+    shadow.setDevicePixelRatio(dpr);
+    return shadow;
+}
+
+QImage roundedShadowAlpha(const QSize &box, int radius, int cornerRadius, qreal dpr, ShadowGenerator generator)
+{
+    const int extent = shadowExtent(radius, generator);
+    const QSize size = (box + 2 * QSize(extent, extent)) * dpr;
+
+    const qreal left = qRound(extent * dpr);
+    const qreal top = qRound(extent * dpr);
+    const qreal right = qMin(qRound((extent + box.width()) * dpr), size.width());
+    const qreal bottom = qMin(qRound((extent + box.height()) * dpr), size.height());
+
+    const QPointF center((left + right) / 2, (top + bottom) / 2);
+    const QPointF halfSize((right - left) / 2, (bottom - top) / 2);
+    const qreal corner = qBound(qreal(0), cornerRadius * dpr, qMin(halfSize.x(), halfSize.y()));
+
+    const qreal sigma = generator == ShadowGenerator::ExactGaussian
+        ? radius * dpr * EXACT_SIGMA_BLUR_SCALE
+        : radiusToSigma(radius * dpr);
+    const qreal scale = sigma > 0 ? 1.0 / (sigma * M_SQRT2) : 0;
+
+    // Coverage of a pixel whose center is `distance` outside the shape.
+    auto coverage = [scale](qreal distance) -> uchar {
+        if (scale == 0) {
+            return distance < 0 ? 0xff : 0;
+        }
+        return static_cast<uchar>(qRound(127.5 * std::erfc(distance * scale)));
+    };
+
+    // Distance of each column (row) past the straight part of the edges,
+    // the `q` of the usual rounded box SDF.
+    auto edgeDistances = [](ScratchArena::Buffer buffer, int length, qreal center, qreal halfSize, qreal corner) {
+        qreal *distances = ScratchArena::local().buffer<qreal>(buffer, length);
+        for (int i = 0; i < length; ++i) {
+            distances[i] = std::abs(i + 0.5 - center) - (halfSize - corner);
+        }
+        return distances;
+    };
+    const qreal *qx = edgeDistances(ScratchArena::Columns, size.width(), center.x(), halfSize.x(), corner);
+    const qreal *qy = edgeDistances(ScratchArena::Rows, size.height(), center.y(), halfSize.y(), corner);
+
+    // Wherever one of them is negative, the SDF is max(qx, qy) - corner and
+    // the coverage is the smaller of the two 1-D profiles.
+    uchar *columns = ScratchArena::local().buffer(ScratchArena::Temporary, size.width());
+    for (int x = 0; x < size.width(); ++x) {
+        columns[x] = coverage(qx[x] - corner);
+    }
+
+    // qx is V shaped, so the straight columns are one run in the middle.
+    // Only the columns outside of it need the full SDF, and only in rows
+    // that are outside of the straight ones as well: the corner tiles.
+    int straightBegin = 0;
+    while (straightBegin < size.width() && qx[straightBegin] > 0) {
+        ++straightBegin;
+    }
+    int straightEnd = size.width();
+    while (straightEnd > straightBegin && qx[straightEnd - 1] > 0) {
+        --straightEnd;
+    }
 
-    QRect shadowRect = shadow.rect();
+    QImage alpha(size, QImage::Format_Alpha8);
+    uchar *bits = alpha.bits();
+    const int bytesPerLine = alpha.bytesPerLine();
+
+    for (int y = 0; y < size.height(); ++y) {
+        uchar *line = bits + y * bytesPerLine;
+        const uchar rowCoverage = coverage(qy[y] - corner);
+
+        // Rows along the left and right edges, and the interior.
+        if (qy[y] <= 0) {
+            if (rowCoverage == 0xff) {
+                std::memcpy(line, columns, size.width());
+            } else {
+                for (int x = 0; x < size.width(); ++x) {
+                    line[x] = qMin(columns[x], rowCoverage);
+                }
+            }
+            continue;
+        }
+
+        // Rows along the top and bottom edges, with a corner tile at
+        // each end.
+        for (int x = 0; x < straightBegin; ++x) {
+            line[x] = coverage(std::hypot(qx[x], qy[y]) - corner);
+        }
+        for (int x = straightBegin; x < straightEnd; ++x) {
+            line[x] = qMin(columns[x], rowCoverage);
+        }
+        for (int x = straightEnd; x < size.width(); ++x) {
+            line[x] = coverage(std::hypot(qx[x], qy[y]) - corner);
+        }
+    }
+
+    alpha.setDevicePixelRatio(dpr);
+    return alpha;
+}
+
+void boxShadow(QPainter *p, const QRect &box, const QPoint &offset, int radius, const QColor &color, ShadowGenerator generator)
+{
+    const qreal dpr = p->device()->devicePixelRatioF();
+
+    const QImage shadow = boxShadowAlpha(box.size(), radius, dpr, generator);
+    const QImage tinted = tintAlpha(shadow, color);
+
+    QRect shadowRect = tinted.rect();
     shadowRect.setSize(shadowRect.size() / dpr);
     shadowRect.moveCenter(box.center() + offset);
-    p->drawImage(shadowRect, shadow);
+    p->drawImage(shadowRect, tinted);
+}
+
+void compositeShadows(QImage &target, const QVector<ShadowLayer> &layers, const QRect &mask)
+{
+    compositeShadows(target.bits(), target.bytesPerLine(), target.size(),
+                     layers.constData(), layers.size(), mask, QRect(0, 0, 1, 1));
+}
+
+void compositeShadows(uchar *bits, int bytesPerLine, const QSize &size,
+                      const ShadowLayer *layers, int layerCount, const QRect &mask,
+                      const QRect &stretch)
+{
+    const int width = size.width();
+    const QRect clippedMask = mask & QRect(QPoint(0, 0), size);
+
+    QVarLengthArray<QRgb, 2> colors;
+    QVarLengthArray<const uchar *, 2> rows;
+    for (int i = 0; i < layerCount; ++i) {
+        Q_ASSERT(layers[i].alpha.format() == QImage::Format_Alpha8);
+        colors.append(qPremultiply(layers[i].color.rgba()));
+        rows.append(nullptr);
+    }
+
+    // Same math as CompositionMode_SourceOver: src + dst * (1 - src alpha).
+    // Column x of the full texture lands in dst[x - shift].
+    auto compositeSpan = [&](QRgb *dst, int begin, int end, int shift) {
+        for (int x = begin; x < end; ++x) {
+            QRgb pixel = 0;
+            for (int i = 0; i < layerCount; ++i) {
+                const int layerX = x - layers[i].topLeft.x();
+                if (!rows[i] || layerX < 0 || layerX >= layers[i].alpha.width()) {
+                    continue;
+                }
+                const uint alpha = rows[i][layerX];
+                if (alpha == 0) {
+                    continue;
+                }
+                const QRgb src = multiplyAlpha(colors[i], alpha);
+                pixel = src + multiplyAlpha(pixel, 255 - qAlpha(src));
+            }
+            dst[x - shift] = pixel;
+        }
+    };
+    auto compositeRow = [&](QRgb *dst, bool masked, int begin, int end, int shift) {
+        if (!masked) {
+            compositeSpan(dst, begin, end, shift);
+            return;
+        }
+        const int maskBegin = qBound(begin, clippedMask.left(), end);
+        const int maskEnd = qBound(begin, clippedMask.right() + 1, end);
+        compositeSpan(dst, begin, maskBegin, shift);
+        std::memset(dst + maskBegin - shift, 0, (maskEnd - maskBegin) * sizeof(QRgb));
+        compositeSpan(dst, maskEnd, end, shift);
+    };
+
+    // Rows and columns strictly after the stretched ones, up to the far
+    // edge of `stretch`, are left out of the target.
+    const int skippedColumns = stretch.right() - stretch.left();
+    int targetY = 0;
+    for (int y = 0; y < size.height(); ++y) {
+        if (stretch.top() < y && y <= stretch.bottom()) {
+            continue;
+        }
+
+        for (int i = 0; i < layerCount; ++i) {
+            const int layerY = y - layers[i].topLeft.y();
+            rows[i] = layerY >= 0 && layerY < layers[i].alpha.height()
+                ? layers[i].alpha.constScanLine(layerY)
+                : nullptr;
+        }
+
+        QRgb *dst = reinterpret_cast<QRgb *>(bits + targetY++ * bytesPerLine);
+        const bool masked = !clippedMask.isEmpty()
+            && y >= clippedMask.top() && y <= clippedMask.bottom();
+        compositeRow(dst, masked, 0, stretch.left() + 1, 0);
+        compositeRow(dst, masked, stretch.right() + 1, width, skippedColumns);
+    }
 }
 
 } // namespace BoxShadowHelper
@@ -19,17 +19,127 @@
 
 // Qt
 #include <QColor>
+#include <QImage>
 #include <QPainter>
 #include <QPoint>
 #include <QRect>
+#include <QVector>
 
 namespace Material
 {
 namespace BoxShadowHelper
 {
 
+enum class ShadowGenerator {
+    // Rasterize the box and blur it with three box blur passes in each
+    // direction. This is the reference implementation.
+    BoxBlur,
+    // A box shadow is the outer product of two blurred 1-D steps. Blur
+    // the steps with the same three box passes and multiply them out.
+    SeparableBox,
+    // Same as SeparableBox, with the steps convolved with an exact
+    // Gaussian (erf) instead.
+    SeparableGaussian,
+    // The CSS blur: a Gaussian with a standard deviation of half the
+    // radius, applied as a precomputed kernel. It reaches further than
+    // the radius, see shadowExtent().
+    ExactGaussian,
+};
+
+// How far a shadow with the given blur radius reaches past its box.
+int shadowExtent(int radius, ShadowGenerator generator);
+
+// Kovesi's box sizes for the three passes the shadows use, in exact
+// integer arithmetic so they can be evaluated at compile time. With a sigma
+// of 7/16 of the radius, sqrt(12 sigma^2 / 3 + 1) is sqrt(49 r^2 + 64) / 8.
+constexpr qint64 integerSqrt(qint64 n, qint64 low, qint64 high)
+{
+    return low == high
+        ? low
+        : (low + high + 1) / 2 <= n / ((low + high + 1) / 2)
+            ? integerSqrt(n, (low + high + 1) / 2, high)
+            : integerSqrt(n, low, (low + high + 1) / 2 - 1);
+}
+
+constexpr qint64 integerSqrt(qint64 n)
+{
+    return integerSqrt(n, 0, n < 2 ? n : n / 2 + 1);
+}
+
+// p / q rounded half away from zero, like std::round().
+constexpr qint64 roundedQuotient(qint64 p, qint64 q)
+{
+    return q < 0
+        ? roundedQuotient(-p, -q)
+        : p >= 0 ? (2 * p + q) / (2 * q) : -((-2 * p + q) / (2 * q));
+}
+
+constexpr int lowerBoxSize(int radius)
+{
+    return integerSqrt(49LL * radius * radius + 64) / 8 % 2 == 0
+        ? int(integerSqrt(49LL * radius * radius + 64) / 8) - 1
+        : int(integerSqrt(49LL * radius * radius + 64) / 8);
+}
+
+constexpr int boxSizeThreshold(int radius, int lower)
+{
+    return int(roundedQuotient(
+        147LL * radius * radius - 64LL * (3LL * lower * lower + 12LL * lower + 9),
+        -256LL * (lower + 1)));
+}
+
+// Size of the box for pass `pass` (0, 1 or 2) of a blur with `radius`
+// in device pixels.
+constexpr int boxSize(int radius, int pass)
+{
+    return pass < boxSizeThreshold(radius, lowerBoxSize(radius))
+        ? lowerBoxSize(radius)
+        : lowerBoxSize(radius) + 2;
+}
+
+// Building blocks of the shadow pipeline, exposed for the benchmark.
+QVector<int> computeBoxSizes(int radius, int numIterations);
+void boxBlurPass(const QImage &src, QImage &dst, int boxSize);
+void boxBlurAlpha(QImage &image, int radius, int numIterations);
+QImage tintAlpha(const QImage &alpha, const QColor &color);
+
+// Blurred alpha of a box shadow, before it is tinted. The plane is
+// `box` grown by shadowExtent() on each side, in device pixels.
+QImage boxShadowAlpha(const QSize &box, int radius, qreal dpr,
+                      ShadowGenerator generator = ShadowGenerator::BoxBlur);
+
+// Rounded counterpart of boxShadowAlpha(). The blurred rounded rectangle
+// is evaluated analytically from its signed distance, using the Gaussian
+// `generator` would approximate. Along the straight edges and inside, that
+// reduces to the smaller of two 1-D profiles, filled in with row copies
+// and clamps. The SDF is only evaluated per pixel in the four corner tiles.
+QImage roundedShadowAlpha(const QSize &box, int radius, int cornerRadius, qreal dpr,
+                          ShadowGenerator generator = ShadowGenerator::ExactGaussian);
+
 void boxShadow(QPainter *p, const QRect &box, const QPoint &offset,
-               int radius, const QColor &color);
+               int radius, const QColor &color,
+               ShadowGenerator generator = ShadowGenerator::BoxBlur);
+
+struct ShadowLayer
+{
+    QImage alpha;   // from boxShadowAlpha()
+    QPoint topLeft; // in device pixels of the target
+    QColor color;
+};
+
+// Tints the layers and composites them over each other, in order, straight
+// into `target` (ARGB32 premultiplied). Pixels inside `mask` are left
+// transparent without being computed. Gives the same pixels as a
+// boxShadow() call per layer followed by a DestinationOut fill of `mask`.
+void compositeShadows(QImage &target, const QVector<ShadowLayer> &layers, const QRect &mask);
+
+// Same, for a nine-patch whose stretched row and column are `stretch`'s
+// top-left ones. The rest of `stretch` would come out exactly the same, so
+// it is left out: `bits` holds size - stretch.size() + (1, 1) pixels, and
+// `size` and `mask` are those of the full texture.
+void compositeShadows(uchar *bits, int bytesPerLine, const QSize &size,
+                      const ShadowLayer *layers, int layerCount, const QRect &mask,
+                      const QRect &stretch);
 
 } // namespace BoxShadowHelper
 } // namespace Material
@@ -19,7 +19,9 @@
 // own
 #include "Button.h"
 #include "Material.h"
+#include "AnimationDriver.h"
 #include "Decoration.h"
+#include "GlyphAtlas.h"
 
 #include "AppIconButton.h"
 #include "ApplicationMenuButton.h"
@@ -35,13 +37,9 @@
 #include <KDecoration2/Decoration>
 #include <KDecoration2/DecorationButton>
 
-// KF
-#include <KColorUtils>
-
 // Qt
 #include <QDebug>
 #include <QPainter>
-#include <QVariantAnimation>
 #include <QtMath> // qFloor
 
 
@@ -51,10 +49,11 @@ namespace Material
 Button::Button(KDecoration2::DecorationButtonType type, Decoration *decoration, QObject *parent)
     : DecorationButton(type, decoration, parent)
     , m_animationEnabled(true)
-    , m_animation(new QVariantAnimation(this))
+    , m_animationDuration(0)
     , m_opacity(1)
     , m_transitionValue(0)
     , m_isGtkButton(false)
+    , m_paintingGlyph(false)
 {
     connect(this, &Button::hoveredChanged, this,
         [this](bool hovered) {
@@ -71,20 +70,7 @@ Button::Button(KDecoration2::DecorationButtonType type, Decoration *decoration,
     // Animation based on SierraBreezeEnhanced
     // https://github.com/kupiqu/SierraBreezeEnhanced/blob/master/breezebutton.cpp#L45
     m_animationEnabled = decoration->animationsEnabled();
-    m_animation->setDuration(decoration->animationsDuration());
-    m_animation->setStartValue(0.0);
-    m_animation->setEndValue(1.0);
-    m_animation->setEasingCurve(QEasingCurve::InOutQuad);
-    connect(m_animation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
-        setTransitionValue(value.toReal());
-    });
-    connect(this, &Button::transitionValueChanged, this, [this]() {
-        update();
-    });
-
-    connect(this, &Button::opacityChanged, this, [this]() {
-        update();
-    });
+    m_animationDuration = decoration->animationsDuration();
 
     setHeight(decoration->titleBarHeight());
 
@@ -130,6 +116,7 @@ Button::Button(KDecoration2::DecorationButtonType type, Decoration *decoration,
 
 Button::~Button()
 {
+    AnimationDriver::self().stop(this);
 }
 
 KDecoration2::DecorationButton* Button::create(KDecoration2::DecorationButtonType type, KDecoration2::Decoration *decoration, QObject *parent)
@@ -162,10 +149,12 @@ Button::Button(QObject *parent, const QVariantList &args)
 
 void Button::paint(QPainter *painter, const QRect &repaintRegion)
 {
-    Q_UNUSED(repaintRegion)
-
     // Buttons are coded assuming 24 units in size.
     const QRectF buttonRect = geometry();
+    if (m_opacity <= 0 || !isVisible() || !repaintRegion.intersects(buttonRect.toAlignedRect())) {
+        return;
+    }
+
     const qreal iconScale = buttonRect.height()/24;
     int iconSize;
     if (m_isGtkButton) {
@@ -210,6 +199,15 @@ void Button::paint(QPainter *painter, const QRect &repaintRegion)
 
 
     // Icon
+    if (!hasGlyph() || !paintGlyph(painter, iconRect, gridUnit)) {
+        paintTypeIcon(painter, iconRect, gridUnit);
+    }
+
+    painter->restore();
+}
+
+void Button::paintTypeIcon(QPainter *painter, const QRectF &iconRect, const qreal gridUnit)
+{
     switch (type()) {
     case KDecoration2::DecorationButtonType::Menu:
         AppIconButton::paintIcon(this, painter, iconRect, gridUnit);
@@ -247,8 +245,79 @@ void Button::paint(QPainter *painter, const QRect &repaintRegion)
         paintIcon(painter, iconRect, gridUnit);
         break;
     }
+}
 
-    painter->restore();
+bool Button::hasGlyph() const
+{
+    switch (type()) {
+    case KDecoration2::DecorationButtonType::ApplicationMenu:
+    case KDecoration2::DecorationButtonType::OnAllDesktops:
+    case KDecoration2::DecorationButtonType::KeepAbove:
+    case KDecoration2::DecorationButtonType::KeepBelow:
+    case KDecoration2::DecorationButtonType::Close:
+    case KDecoration2::DecorationButtonType::Maximize:
+    case KDecoration2::DecorationButtonType::Minimize:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool Button::paintGlyph(QPainter *painter, const QRectF &iconRect, const qreal gridUnit)
+{
+    // Glyphs are pixel aligned, so anything but a translation needs the
+    // strokes painted directly.
+    const QTransform transform = painter->transform();
+    if (!painter->device() || transform.type() > QTransform::TxTranslate) {
+        return false;
+    }
+
+    // Where the icon lands in device pixels, split into a whole pixel and
+    // a quarter pixel offset that is baked into the glyph.
+    const qreal dpr = painter->device()->devicePixelRatioF();
+    const QPointF devicePos = transform.map(iconRect.topLeft()) * dpr;
+    QPoint pixel(qFloor(devicePos.x()), qFloor(devicePos.y()));
+    QPoint subpixel(qRound((devicePos.x() - pixel.x()) * 4), qRound((devicePos.y() - pixel.y()) * 4));
+    if (subpixel.x() == 4) {
+        pixel.rx() += 1;
+        subpixel.setX(0);
+    }
+    if (subpixel.y() == 4) {
+        pixel.ry() += 1;
+        subpixel.setY(0);
+    }
+
+    // Strokes are centered on the icon's outline, leave room for the
+    // widest pen.
+    const int margin = qCeil(iconLineWidth(gridUnit) * 2 * dpr) + 1;
+    const QSize size(qCeil(iconRect.width() * dpr) + 2 * margin + 1,
+                     qCeil(iconRect.height() * dpr) + 2 * margin + 1);
+
+    GlyphKey key;
+    key.type = int(type());
+    key.checked = isChecked();
+    key.iconSize = qRound(iconRect.height());
+    key.devicePixelRatio = dpr;
+    key.subpixelX = subpixel.x();
+    key.subpixelY = subpixel.y();
+
+    const QImage glyph = GlyphAtlas::self().glyph(key, size, [&](QPainter *glyphPainter) {
+        glyphPainter->translate(margin + subpixel.x() / 4.0, margin + subpixel.y() / 4.0);
+        glyphPainter->scale(dpr, dpr);
+        glyphPainter->setRenderHints(QPainter::Antialiasing, false);
+
+        m_paintingGlyph = true;
+        setPenWidth(glyphPainter, gridUnit, 1);
+        glyphPainter->setBrush(Qt::NoBrush);
+        paintTypeIcon(glyphPainter, QRectF(QPointF(0, 0), iconRect.size()), gridUnit);
+        m_paintingGlyph = false;
+    });
+
+    const QPointF glyphPos = QPointF(pixel - QPoint(margin, margin)) / dpr
+        - QPointF(transform.dx(), transform.dy());
+    GlyphAtlas::self().draw(painter, glyphPos, glyph, foregroundColor());
+    return true;
 }
 
 void Button::paintIcon(QPainter *painter, const QRectF &iconRect, const qreal gridUnit)
@@ -271,7 +340,8 @@ qreal Button::iconLineWidth(const qreal gridUnit) const
 
 void Button::setPenWidth(QPainter *painter, const qreal gridUnit, const qreal scale)
 {
-    QPen pen(foregroundColor());
+    // Glyphs only record coverage, they're tinted when drawn.
+    QPen pen(m_paintingGlyph ? QColor(Qt::black) : foregroundColor());
     pen.setCapStyle(Qt::RoundCap);
     pen.setJoinStyle(Qt::MiterJoin);
     pen.setWidthF(iconLineWidth(gridUnit) * scale);
@@ -285,69 +355,7 @@ QColor Button::backgroundColor() const
         return {};
     }
 
-    //--- CloseButton
-    if (type() == KDecoration2::DecorationButtonType::Close) {
-        auto *decoratedClient = deco->client().toStrongRef().data();
-        const QColor hoveredColor = decoratedClient->color(
-            KDecoration2::ColorGroup::Warning,
-            KDecoration2::ColorRole::Foreground
-        );
-        QColor normalColor = QColor(hoveredColor);
-        normalColor.setAlphaF(0);
-
-        if (isPressed()) {
-            const QColor pressedColor = decoratedClient->color(
-                KDecoration2::ColorGroup::Warning,
-                KDecoration2::ColorRole::Foreground
-            ).lighter();
-            return KColorUtils::mix(normalColor, pressedColor, m_transitionValue);
-        }
-
-        if (isHovered()) {
-            return KColorUtils::mix(normalColor, hoveredColor, m_transitionValue);
-        }
-    }
-
-    //--- Checked
-    if (isChecked() && type() != KDecoration2::DecorationButtonType::Maximize) {
-        const QColor normalColor = deco->titleBarForegroundColor();
-
-        if (isPressed()) {
-            const QColor pressedColor = KColorUtils::mix(
-                deco->titleBarBackgroundColor(),
-                deco->titleBarForegroundColor(),
-                0.7);
-            return KColorUtils::mix(normalColor, pressedColor, m_transitionValue);
-        }
-        if (isHovered()) {
-            const QColor hoveredColor = KColorUtils::mix(
-                deco->titleBarBackgroundColor(),
-                deco->titleBarForegroundColor(),
-                0.8);
-            return KColorUtils::mix(normalColor, hoveredColor, m_transitionValue);
-        }
-        return normalColor;
-    }
-
-    //--- Normal
-    const QColor hoveredColor = KColorUtils::mix(
-        deco->titleBarBackgroundColor(),
-        deco->titleBarForegroundColor(),
-        0.2);
-    QColor normalColor = QColor(hoveredColor);
-    normalColor.setAlphaF(0);
-
-    if (isPressed()) {
-        const QColor pressedColor = KColorUtils::mix(
-            deco->titleBarBackgroundColor(),
-            deco->titleBarForegroundColor(),
-            0.3);
-        return KColorUtils::mix(normalColor, pressedColor, m_transitionValue);
-    }
-    if (isHovered()) {
-        return KColorUtils::mix(normalColor, hoveredColor, m_transitionValue);
-    }
-    return normalColor;
+    return transitionColor(deco->buttonColors().background[colorKind()]);
 }
 
 QColor Button::foregroundColor() const
@@ -357,36 +365,46 @@ QColor Button::foregroundColor() const
         return {};
     }
 
-    //--- Checked
+    return transitionColor(deco->buttonColors().foreground[colorKind()]);
+}
+
+int Button::colorKind() const
+{
+    if (type() == KDecoration2::DecorationButtonType::Close) {
+        return Decoration::CloseButtonKind;
+    }
     if (isChecked() && type() != KDecoration2::DecorationButtonType::Maximize) {
-        QColor activeColor = KColorUtils::mix(
-            deco->titleBarBackgroundColor(),
-            deco->titleBarForegroundColor(),
-            0.2);
-
-        if (isPressed() || isHovered()) {
-            return KColorUtils::mix(
-                activeColor,
-                deco->titleBarBackgroundColor(),
-                m_transitionValue);
-        }
-        return activeColor;
+        return Decoration::CheckedButtonKind;
+    }
+    return Decoration::NormalButtonKind;
+}
+
+QColor Button::transitionColor(const QRgb *colors) const
+{
+    int state = Decoration::NormalButtonState;
+    if (isPressed()) {
+        state = Decoration::PressedButtonState;
+    } else if (isHovered()) {
+        state = Decoration::HoveredButtonState;
     }
 
-    //--- Normal
-    QColor normalColor = KColorUtils::mix(
-        deco->titleBarBackgroundColor(),
-        deco->titleBarForegroundColor(),
-        0.8);
-
-    if (isPressed() || isHovered()) {
-        return KColorUtils::mix(
-            normalColor,
-            deco->titleBarForegroundColor(),
-            m_transitionValue);
+    const QRgb from = colors[Decoration::NormalButtonState];
+    if (state == Decoration::NormalButtonState || m_transitionValue >= 1) {
+        return QColor::fromRgba(qUnpremultiply(colors[state]));
     }
 
-    return normalColor;
+    // Linear in premultiplied space, so fading in from transparent keeps
+    // the hue of the target color.
+    const QRgb to = colors[state];
+    const qreal t = qMax<qreal>(0, m_transitionValue);
+    const auto blend = [t](int a, int b) {
+        return a + qRound((b - a) * t);
+    };
+    return QColor::fromRgba(qUnpremultiply(qRgba(
+        blend(qRed(from), qRed(to)),
+        blend(qGreen(from), qGreen(to)),
+        blend(qBlue(from), qBlue(to)),
+        blend(qAlpha(from), qAlpha(to)))));
 }
 
 
@@ -405,13 +423,13 @@ void Button::setAnimationEnabled(bool value)
 
 int Button::animationDuration() const
 {
-    return m_animation->duration();
+    return m_animationDuration;
 }
 
 void Button::setAnimationDuration(int value)
 {
-    if (m_animation->duration() != value) {
-        m_animation->setDuration(value);
+    if (m_animationDuration != value) {
+        m_animationDuration = value;
         emit animationDurationChanged();
     }
 }
@@ -423,10 +441,19 @@ qreal Button::opacity() const
 
 void Button::setOpacity(qreal value)
 {
-    if (m_opacity != value) {
-        m_opacity = value;
-        emit opacityChanged();
+    if (applyOpacity(value)) {
+        update();
+    }
+}
+
+bool Button::applyOpacity(qreal value)
+{
+    if (m_opacity == value) {
+        return false;
     }
+    m_opacity = value;
+    emit opacityChanged();
+    return true;
 }
 
 qreal Button::transitionValue() const
@@ -439,21 +466,24 @@ void Button::setTransitionValue(qreal value)
     if (m_transitionValue != value) {
         m_transitionValue = value;
         emit transitionValueChanged(value);
+        update();
     }
 }
 
 void Button::updateAnimationState(bool hovered)
 {
     if (m_animationEnabled) {
-        QAbstractAnimation::Direction dir = hovered ? QAbstractAnimation::Forward : QAbstractAnimation::Backward;
-        if (m_animation->state() == QAbstractAnimation::Running && m_animation->direction() != dir) {
-            m_animation->stop();
-        }
-        m_animation->setDirection(dir);
-        if (m_animation->state() != QAbstractAnimation::Running) {
-            m_animation->start();
-        }
+        // The driver repaints every button it stepped in one go.
+        AnimationDriver::self().start(this, decoration().data(), hovered, m_animationDuration,
+            [this](qreal value) {
+                if (m_transitionValue != value) {
+                    m_transitionValue = value;
+                    emit transitionValueChanged(value);
+                }
+                return geometry().toAlignedRect();
+            });
     } else {
+        AnimationDriver::self().stop(this);
         setTransitionValue(1);
     }
 }
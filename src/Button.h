@@ -23,7 +23,7 @@
 #include <KDecoration2/DecorationButton>
 
 // Qt
-#include <QVariantAnimation>
+#include <QRgb>
 
 namespace Material
 {
@@ -63,6 +63,10 @@ public:
     virtual QColor backgroundColor() const;
     virtual QColor foregroundColor() const;
 
+    // Index into Decoration::ButtonColors.
+    int colorKind() const;
+    QColor transitionColor(const QRgb *colors) const;
+
     bool animationEnabled() const;
     void setAnimationEnabled(bool value);
 
@@ -71,6 +75,8 @@ public:
 
     qreal opacity() const;
     void setOpacity(qreal value);
+    // Like setOpacity(), but leaves the repaint to the caller.
+    bool applyOpacity(qreal value);
 
     qreal transitionValue() const;
     void setTransitionValue(qreal value);
@@ -78,6 +84,11 @@ public:
 private Q_SLOTS:
     void updateAnimationState(bool hovered);
 
+private:
+    void paintTypeIcon(QPainter *painter, const QRectF &iconRect, const qreal gridUnit);
+    bool hasGlyph() const;
+    bool paintGlyph(QPainter *painter, const QRectF &iconRect, const qreal gridUnit);
+
 signals:
     void animationEnabledChanged();
     void animationDurationChanged();
@@ -86,10 +97,11 @@ signals:
 
 private:
     bool m_animationEnabled;
-    QVariantAnimation *m_animation;
+    int m_animationDuration;
     qreal m_opacity;
     qreal m_transitionValue;
     bool m_isGtkButton;
+    bool m_paintingGlyph;
 };
 
 } // namespace Material
@@ -57,6 +57,7 @@ ConfigurationModule::ConfigurationModule(QWidget *parent, const QVariantList &ar
     , m_titleAlignment(InternalSettings::AlignCenterFullWidth)
     , m_buttonSize(InternalSettings::ButtonDefault)
     , m_shadowSize(InternalSettings::ShadowVeryLarge)
+    , m_shadowQuality(InternalSettings::ShadowQualityFast)
 {
     init();
 }
@@ -90,6 +91,14 @@ void ConfigurationModule::init()
     titleAlignment->setObjectName(QStringLiteral("kcfg_TitleAlignment"));
     generalForm->addRow(i18nd("breeze_kwin_deco", "Tit&le alignment:"), titleAlignment);
 
+    QSpinBox *inactiveCaptionRate = new QSpinBox(generalTab);
+    inactiveCaptionRate->setMinimum(1);
+    inactiveCaptionRate->setMaximum(60);
+    inactiveCaptionRate->setSuffix(i18n(" per second"));
+    inactiveCaptionRate->setToolTip(i18n("How often the title of an inactive window may be redrawn while it keeps changing"));
+    inactiveCaptionRate->setObjectName(QStringLiteral("kcfg_InactiveCaptionRate"));
+    generalForm->addRow(i18n("Inactive title updates:"), inactiveCaptionRate);
+
     QComboBox *buttonSizes = new QComboBox(generalTab);
     buttonSizes->addItem(i18nd("breeze_kwin_deco", "Tiny"));
     buttonSizes->addItem(i18ndc("breeze_kwin_deco", "@item:inlistbox Button size:", "Small"));
@@ -178,6 +187,24 @@ void ConfigurationModule::init()
     shadowSizes->setObjectName(QStringLiteral("kcfg_ShadowSize"));
     shadowForm->addRow(i18nd("breeze_kwin_deco", "Si&ze:"), shadowSizes);
 
+    QComboBox *shadowQuality = new QComboBox(shadowTab);
+    shadowQuality->addItem(i18n("Fast"));
+    shadowQuality->addItem(i18n("Balanced"));
+    shadowQuality->addItem(i18n("Exact"));
+    shadowQuality->setItemData(0, i18n("Approximates the blur with box filters"), Qt::ToolTipRole);
+    shadowQuality->setItemData(1, i18n("Gaussian falloff, trimmed to fit the shadow size"), Qt::ToolTipRole);
+    shadowQuality->setItemData(2, i18n("Gaussian falloff as specified by CSS, with a larger shadow"), Qt::ToolTipRole);
+    shadowQuality->setObjectName(QStringLiteral("kcfg_ShadowQuality"));
+    shadowForm->addRow(i18n("&Quality:"), shadowQuality);
+
+    QSpinBox *shadowCornerRadius = new QSpinBox(shadowTab);
+    shadowCornerRadius->setMinimum(0);
+    shadowCornerRadius->setMaximum(32);
+    shadowCornerRadius->setSuffix(i18n(" px"));
+    shadowCornerRadius->setSpecialValueText(i18n("Square"));
+    shadowCornerRadius->setObjectName(QStringLiteral("kcfg_ShadowCornerRadius"));
+    shadowForm->addRow(i18n("Corner &Radius:"), shadowCornerRadius);
+
     QSpinBox *shadowStrength = new QSpinBox(shadowTab);
     shadowStrength->setMinimum(25);
     shadowStrength->setMaximum(255);
@@ -196,6 +223,12 @@ void ConfigurationModule::init()
         InternalSettings::AlignCenterFullWidth,
         QStringLiteral("TitleAlignment")
     );
+    skel->addItemInt(
+        QStringLiteral("InactiveCaptionRate"),
+        m_inactiveCaptionRate,
+        10,
+        QStringLiteral("InactiveCaptionRate")
+    );
     skel->addItemInt(
         QStringLiteral("ButtonSize"),
         m_buttonSize,
@@ -238,6 +271,18 @@ void ConfigurationModule::init()
         InternalSettings::ShadowVeryLarge,
         QStringLiteral("ShadowSize")
     );
+    skel->addItemInt(
+        QStringLiteral("ShadowQuality"),
+        m_shadowQuality,
+        InternalSettings::ShadowQualityFast,
+        QStringLiteral("ShadowQuality")
+    );
+    skel->addItemInt(
+        QStringLiteral("ShadowCornerRadius"),
+        m_shadowCornerRadius,
+        0,
+        QStringLiteral("ShadowCornerRadius")
+    );
     skel->addItemInt(
         QStringLiteral("ShadowStrength"),
         m_shadowStrength,
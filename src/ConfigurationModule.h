@@ -36,6 +36,7 @@ private:
     void init();
 
     int m_titleAlignment;
+    int m_inactiveCaptionRate;
     int m_buttonSize;
     double m_activeOpacity;
     double m_inactiveOpacity;
@@ -43,6 +44,8 @@ private:
     bool m_animationsEnabled;
     int m_animationsDuration;
     int m_shadowSize;
+    int m_shadowQuality;
+    int m_shadowCornerRadius;
     int m_shadowStrength;
     QColor m_shadowColor;
 };
@@ -21,10 +21,14 @@
 // own
 #include "Decoration.h"
 #include "Material.h"
+#include "AnimationDriver.h"
 #include "AppMenuButtonGroup.h"
 #include "BoxShadowHelper.h"
 #include "Button.h"
+#include "GlyphAtlas.h"
 #include "InternalSettings.h"
+#include "ShadowCache.h"
+#include "ShadowRenderer.h"
 
 // KDecoration
 #include <KDecoration2/DecoratedClient>
@@ -33,6 +37,9 @@
 #include <KDecoration2/DecorationSettings>
 #include <KDecoration2/DecorationShadow>
 
+// KF
+#include <KColorUtils>
+
 // Qt
 #include <QApplication>
 #include <QDebug>
@@ -40,8 +47,12 @@
 #include <QMouseEvent>
 #include <QPainter>
 #include <QSharedPointer>
+#include <QStyle>
 #include <QWheelEvent>
 
+// std
+#include <limits>
+
 // X11
 #include <xcb/xcb.h>
 #include <QX11Info>
@@ -50,102 +61,13 @@
 namespace Material
 {
 
-namespace
-{
-
-struct ShadowParams
-{
-    ShadowParams() = default;
-
-    ShadowParams(const QPoint &offset, int radius, qreal opacity)
-        : offset(offset)
-        , radius(radius)
-        , opacity(opacity) {}
-
-    QPoint offset;
-    int radius = 0;
-    qreal opacity = 0;
-};
-
-struct CompositeShadowParams
-{
-    CompositeShadowParams() = default;
-
-    CompositeShadowParams(
-            const QPoint &offset,
-            const ShadowParams &shadow1,
-            const ShadowParams &shadow2)
-        : offset(offset)
-        , shadow1(shadow1)
-        , shadow2(shadow2) {}
-
-    bool isNone() const {
-        return qMax(shadow1.radius, shadow2.radius) == 0;
-    }
-
-    QPoint offset;
-    ShadowParams shadow1;
-    ShadowParams shadow2;
-};
-
-// const CompositeShadowParams s_shadowParams = CompositeShadowParams(
-//     QPoint(0, 18),
-//     ShadowParams(QPoint(0, 0), 64, 0.8),
-//     ShadowParams(QPoint(0, -10), 24, 0.1)
-// );
-const CompositeShadowParams s_shadowParams[] = {
-    // None
-    CompositeShadowParams(),
-    // Small
-    CompositeShadowParams(
-        QPoint(0, 4),
-        ShadowParams(QPoint(0, 0), 16, 1),
-        ShadowParams(QPoint(0, -2), 8, 0.4)),
-    // Medium
-    CompositeShadowParams(
-        QPoint(0, 8),
-        ShadowParams(QPoint(0, 0), 32, 0.9),
-        ShadowParams(QPoint(0, -4), 16, 0.3)),
-    // Large
-    CompositeShadowParams(
-        QPoint(0, 12),
-        ShadowParams(QPoint(0, 0), 48, 0.8),
-        ShadowParams(QPoint(0, -6), 24, 0.2)),
-    // Very large
-    CompositeShadowParams(
-        QPoint(0, 16),
-        ShadowParams(QPoint(0, 0), 64, 0.7),
-        ShadowParams(QPoint(0, -8), 32, 0.1)),
-};
-
-inline CompositeShadowParams lookupShadowParams(int size)
-{
-    switch (size) {
-    case InternalSettings::ShadowNone:
-        return s_shadowParams[0];
-    case InternalSettings::ShadowSmall:
-        return s_shadowParams[1];
-    case InternalSettings::ShadowMedium:
-        return s_shadowParams[2];
-    default:
-    case InternalSettings::ShadowLarge:
-        return s_shadowParams[3];
-    case InternalSettings::ShadowVeryLarge:
-        return s_shadowParams[4];
-    }
-}
-
-} // anonymous namespace
-
 static int s_decoCount = 0;
-static int s_shadowSizePreset = InternalSettings::ShadowVeryLarge;
-static int s_shadowStrength = 255;
-static QColor s_shadowColor = QColor(33, 33, 33);
-static QSharedPointer<KDecoration2::DecorationShadow> s_cachedShadow;
 
 Decoration::Decoration(QObject *parent, const QVariantList &args)
     : KDecoration2::Decoration(parent, args)
+    , m_menuButtons(nullptr)
     , m_internalSettings(nullptr)
+    , m_devicePixelRatio(qApp->devicePixelRatio())
 {
     ++s_decoCount;
 }
@@ -153,7 +75,8 @@ Decoration::Decoration(QObject *parent, const QVariantList &args)
 Decoration::~Decoration()
 {
     if (--s_decoCount == 0) {
-        s_cachedShadow.clear();
+        ShadowCache::self().clear();
+        GlyphAtlas::self().clear();
     }
 }
 
@@ -161,13 +84,29 @@ void Decoration::paint(QPainter *painter, const QRect &repaintRegion)
 {
     auto *decoratedClient = client().toStrongRef().data();
 
+    // The painter tells us which device pixel ratio we are rendered at.
+    // Don't swap the shadow in the middle of a paint.
+    const qreal dpr = painter->device() ? painter->device()->devicePixelRatioF() : m_devicePixelRatio;
+    if (!qFuzzyCompare(dpr, m_devicePixelRatio)) {
+        m_devicePixelRatio = dpr;
+        QMetaObject::invokeMethod(this, &Decoration::updateShadow, Qt::QueuedConnection);
+    }
+
+    // Hover animations only dirty a single button, so every stage below
+    // limits itself to repaintRegion and the clip keeps fills inside it.
+    painter->save();
+    painter->setClipRect(repaintRegion, Qt::IntersectClip);
+
     if (!decoratedClient->isShaded()) {
         paintFrameBackground(painter, repaintRegion);
     }
 
-    paintTitleBarBackground(painter, repaintRegion);
-    paintButtons(painter, repaintRegion);
-    paintCaption(painter, repaintRegion);
+    if (repaintRegion.intersects(QRect(0, 0, size().width(), titleBarHeight()))) {
+        paintTitleBarLayer(painter, repaintRegion);
+        paintButtons(painter, repaintRegion);
+    }
+
+    painter->restore();
 }
 
 void Decoration::init()
@@ -176,6 +115,8 @@ void Decoration::init()
 
     auto *decoratedClient = client().toStrongRef().data();
 
+    connect(decoratedClient, &KDecoration2::DecoratedClient::widthChanged,
+            this, &Decoration::invalidateTitleBarLayer);
     connect(decoratedClient, &KDecoration2::DecoratedClient::widthChanged,
             this, &Decoration::updateTitleBar);
     connect(decoratedClient, &KDecoration2::DecoratedClient::widthChanged,
@@ -184,13 +125,29 @@ void Decoration::init()
             this, &Decoration::updateButtonsGeometry);
 
     auto repaintTitleBar = [this] {
+        invalidateTitleBarLayer();
         update(titleBar());
     };
 
+    m_captionTimer.setSingleShot(true);
+    connect(&m_captionTimer, &QTimer::timeout,
+            this, &Decoration::updateCaption);
     connect(decoratedClient, &KDecoration2::DecoratedClient::captionChanged,
-            this, repaintTitleBar);
+            this, &Decoration::scheduleCaptionUpdate);
+    connect(decoratedClient, &KDecoration2::DecoratedClient::activeChanged,
+            this, &Decoration::invalidateButtonColors);
     connect(decoratedClient, &KDecoration2::DecoratedClient::activeChanged,
             this, repaintTitleBar);
+    connect(decoratedClient, &KDecoration2::DecoratedClient::paletteChanged,
+            this, &Decoration::invalidateButtonColors);
+    connect(decoratedClient, &KDecoration2::DecoratedClient::paletteChanged,
+            this, repaintTitleBar);
+    connect(&ShadowCache::self(), &ShadowCache::shadowReady,
+        this, [this](const ShadowKey &key, const QSharedPointer<KDecoration2::DecorationShadow> &shadow) {
+            if (key == m_shadowKey) {
+                setShadow(shadow);
+            }
+        });
 
     updateBorders();
     updateResizeBorders();
@@ -210,8 +167,6 @@ void Decoration::init()
     m_menuButtons->setAlwaysShow(m_internalSettings->menuAlwaysShow());
     connect(m_menuButtons, &AppMenuButtonGroup::menuUpdated,
             this, &Decoration::updateButtonsGeometry);
-    connect(m_menuButtons, &AppMenuButtonGroup::opacityChanged,
-            this, repaintTitleBar);
     connect(m_menuButtons, &AppMenuButtonGroup::alwaysShowChanged,
             this, repaintTitleBar);
     m_menuButtons->updateAppMenuModel();
@@ -236,6 +191,9 @@ void Decoration::reconfigure()
 {
     m_internalSettings->load();
 
+    resetFontMetrics();
+    invalidateButtonColors();
+    invalidateTitleBarLayer();
     updateBorders();
     updateTitleBar();
     m_menuButtons->setAlwaysShow(m_internalSettings->menuAlwaysShow());
@@ -395,6 +353,8 @@ void Decoration::updateButtonHeight()
 
 void Decoration::updateButtonsGeometry()
 {
+    // The caption is laid out around the buttons.
+    invalidateTitleBarLayer();
     updateButtonHeight();
 
     if (!m_leftButtons->buttons().isEmpty()) {
@@ -455,89 +415,38 @@ void Decoration::updateButtonAnimation()
 
 void Decoration::updateShadow()
 {
-    const QColor shadowColor = m_internalSettings->shadowColor();
-    const int shadowStrengthInt = m_internalSettings->shadowStrength();
-    const int shadowSizePreset = m_internalSettings->shadowSize();
-
-    if (!s_cachedShadow.isNull()
-        && s_shadowColor == shadowColor
-        && s_shadowSizePreset == shadowSizePreset
-        && s_shadowStrength == shadowStrengthInt
-    ) {
-        setShadow(s_cachedShadow);
+    ShadowKey key;
+    key.preset = m_internalSettings->shadowSize();
+    key.quality = m_internalSettings->shadowQuality();
+    key.cornerRadius = m_internalSettings->shadowCornerRadius();
+    key.color = m_internalSettings->shadowColor().rgba();
+    key.strength = m_internalSettings->shadowStrength();
+    key.devicePixelRatio = m_devicePixelRatio;
+    m_shadowKey = key;
+
+    if (ShadowRenderer::isNone(key.preset)) {
+        setShadow(QSharedPointer<KDecoration2::DecorationShadow>());
         return;
     }
 
-    s_shadowColor = shadowColor;
-    s_shadowStrength = shadowStrengthInt;
-    s_shadowSizePreset = shadowSizePreset;
-
-    auto withOpacity = [] (const QColor &color, qreal opacity) -> QColor {
-        QColor c(color);
-        c.setAlphaF(opacity);
-        return c;
-    };
-
-    const qreal shadowStrength = static_cast<qreal>(shadowStrengthInt) / 255.0;
-    const CompositeShadowParams params = lookupShadowParams(shadowSizePreset);
-
-    if (params.isNone()) { // InternalSettings::ShadowNone
-        s_cachedShadow.clear();
-        setShadow(s_cachedShadow);
+    ShadowCache &cache = ShadowCache::self();
+    QSharedPointer<KDecoration2::DecorationShadow> cached = cache.shadow(key);
+    if (cached.isNull()) {
+        // Only the color or strength changed, e.g. while previewing in the KCM.
+        cached = cache.retint(key);
+    }
+    if (!cached.isNull()) {
+        setShadow(cached);
         return;
     }
 
-    // In order to properly render a box shadow with a given radius `shadowSize`,
-    // the box size should be at least `2 * QSize(shadowSize, shadowSize)`.
-    const int shadowSize = qMax(params.shadow1.radius, params.shadow2.radius);
-    const QSize boxSize = QSize(1, 1) + QSize(shadowSize*2, shadowSize*2);
-    const QRect box(QPoint(shadowSize, shadowSize), boxSize);
-    const QRect rect = box.adjusted(-shadowSize, -shadowSize, shadowSize, shadowSize);
-
-    QImage shadowTexture(rect.size(), QImage::Format_ARGB32_Premultiplied);
-    shadowTexture.fill(Qt::transparent);
-
-    QPainter painter(&shadowTexture);
-    painter.setRenderHint(QPainter::Antialiasing);
-
-    // Draw the "shape" shadow.
-    BoxShadowHelper::boxShadow(
-        &painter,
-        box,
-        params.shadow1.offset,
-        params.shadow1.radius,
-        withOpacity(shadowColor, params.shadow1.opacity * shadowStrength));
-
-    // Draw the "contrast" shadow.
-    BoxShadowHelper::boxShadow(
-        &painter,
-        box,
-        params.shadow2.offset,
-        params.shadow2.radius,
-        withOpacity(shadowColor, params.shadow2.opacity * shadowStrength));
-
-    // Mask out inner rect.
-    const QMargins padding = QMargins(
-        shadowSize - params.offset.x(),
-        shadowSize - params.offset.y(),
-        shadowSize + params.offset.x(),
-        shadowSize + params.offset.y());
-    const QRect innerRect = rect - padding;
-
-    // Mask out window+titlebar from shadow
-    painter.setPen(Qt::NoPen);
-    painter.setBrush(Qt::black);
-    painter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
-    painter.drawRect(innerRect);
-
-    painter.end();
-
-    s_cachedShadow = QSharedPointer<KDecoration2::DecorationShadow>::create();
-    s_cachedShadow->setPadding(padding);
-    s_cachedShadow->setInnerShadowRect(QRect(shadowTexture.rect().center(), QSize(1, 1)));
-    s_cachedShadow->setShadow(shadowTexture);
-
-    setShadow(s_cachedShadow);
+    // Keep the current shadow until the new one has been rendered. Fresh
+    // decorations borrow a cached shadow that only differs in color, if
+    // there is one.
+    if (shadow().isNull()) {
+        setShadow(cache.placeholder(key));
+    }
+    cache.request(key);
 }
 
 bool Decoration::animationsEnabled() const
@@ -570,8 +479,10 @@ int Decoration::buttonPadding() const
 
 int Decoration::titleBarHeight() const
 {
-    const QFontMetrics fontMetrics(settings()->font());
-    return buttonPadding()*2 + fontMetrics.height();
+    if (m_fontHeight < 0) {
+        m_fontHeight = QFontMetrics(settings()->font()).height();
+    }
+    return buttonPadding()*2 + m_fontHeight;
 }
 
 int Decoration::appMenuCaptionSpacing() const
@@ -591,13 +502,32 @@ bool Decoration::titleBarIsHovered() const
 
 int Decoration::getTextWidth(const QString text, bool showMnemonic) const
 {
+    QHash<QString, int> &textWidths = m_textWidths[showMnemonic ? 1 : 0];
+    const auto it = textWidths.constFind(text);
+    if (it != textWidths.constEnd()) {
+        return it.value();
+    }
+
     const QFontMetrics fontMetrics(settings()->font());
     const QRect titleBarRect(0, 0, size().width(), titleBarHeight());
     int flags = showMnemonic ? Qt::TextShowMnemonic : Qt::TextHideMnemonic;
     const QRect boundingRect = fontMetrics.boundingRect(titleBarRect, flags, text);
+
+    // Menu labels come and go with the application, don't let them pile up.
+    if (textWidths.size() >= 256) {
+        textWidths.clear();
+    }
+    textWidths.insert(text, boundingRect.width());
     return boundingRect.width();
 }
 
+void Decoration::resetFontMetrics()
+{
+    m_fontHeight = -1;
+    m_textWidths[0].clear();
+    m_textWidths[1].clear();
+}
+
 //* scoped pointer convenience typedef
 template <typename T> using ScopedPointer = QScopedPointer<T, QScopedPointerPodDeleter>;
 
@@ -734,15 +664,107 @@ void Decoration::sendMoveEvent(const QPoint pos)
     xcb_flush(connection);
 }
 
+void Decoration::invalidateTitleBarLayer()
+{
+    m_titleBarLayerDirty = true;
+}
+
+// Unless the menu is always shown, the caption makes way for it while
+// it's hovered.
+bool Decoration::captionFadesWithMenu() const
+{
+    return !m_menuButtons->buttons().isEmpty() && !m_menuButtons->alwaysShow();
+}
+
+// What changes when the menu's opacity does.
+QRect Decoration::menuFadeRect() const
+{
+    // The menu group repaints from its constructor, before it's assigned.
+    if (!m_menuButtons) {
+        return QRect();
+    }
+    QRect rect = m_menuButtons->geometry().toAlignedRect();
+    if (captionFadesWithMenu()) {
+        rect |= m_captionLayout.bounds;
+    }
+    return rect;
+}
+
+void Decoration::paintTitleBarLayer(QPainter *painter, const QRect &repaintRegion)
+{
+    const QRect titleBarRect(0, 0, size().width(), titleBarHeight());
+    const QRect dirtyRect = titleBarRect & repaintRegion;
+    if (dirtyRect.isEmpty()) {
+        return;
+    }
+
+    const qreal dpr = m_devicePixelRatio;
+    const QSize layerSize = titleBarRect.size() * dpr;
+
+    // Button hover animations only blit the part behind the button, the
+    // background and caption are redrawn when something they show changes.
+    if (m_titleBarLayerDirty
+            || m_titleBarLayer.size() != layerSize
+            || !qFuzzyCompare(m_titleBarLayer.devicePixelRatioF(), dpr)) {
+        if (m_titleBarLayer.size() != layerSize) {
+            m_titleBarLayer = QImage(layerSize, QImage::Format_ARGB32_Premultiplied);
+        }
+        m_titleBarLayer.setDevicePixelRatio(dpr);
+        m_titleBarLayer.fill(Qt::transparent);
+
+        QPainter layerPainter(&m_titleBarLayer);
+        layerPainter.setRenderHints(painter->renderHints());
+        paintTitleBarBackground(&layerPainter, titleBarRect);
+        if (!captionFadesWithMenu()) {
+            paintCaption(&layerPainter, titleBarRect);
+        }
+        layerPainter.end();
+
+        m_captionLayer = QImage();
+        updateCaptionLayout();
+        const QRect &captionBounds = m_captionLayout.bounds;
+        if (captionFadesWithMenu() && !captionBounds.isEmpty()) {
+            m_captionLayer = QImage(captionBounds.size() * dpr, QImage::Format_ARGB32_Premultiplied);
+            m_captionLayer.setDevicePixelRatio(dpr);
+            m_captionLayer.fill(Qt::transparent);
+
+            QPainter captionPainter(&m_captionLayer);
+            captionPainter.setRenderHints(painter->renderHints());
+            captionPainter.translate(-captionBounds.topLeft());
+            paintCaption(&captionPainter, captionBounds);
+            captionPainter.end();
+        }
+
+        m_titleBarLayerDirty = false;
+    }
+
+    const QRectF sourceRect(QPointF(dirtyRect.topLeft()) * dpr, QSizeF(dirtyRect.size()) * dpr);
+    painter->drawImage(QRectF(dirtyRect), m_titleBarLayer, sourceRect);
+
+    const QRect captionRect = m_captionLayout.bounds & dirtyRect;
+    const qreal captionOpacity = 1.0 - m_menuButtons->opacity();
+    if (!m_captionLayer.isNull() && !captionRect.isEmpty() && captionOpacity > 0) {
+        const QPointF captionOffset = captionRect.topLeft() - m_captionLayout.bounds.topLeft();
+        const QRectF captionSource(captionOffset * dpr, QSizeF(captionRect.size()) * dpr);
+        painter->save();
+        painter->setOpacity(captionOpacity);
+        painter->drawImage(QRectF(captionRect), m_captionLayer, captionSource);
+        painter->restore();
+    }
+}
+
 void Decoration::paintFrameBackground(QPainter *painter, const QRect &repaintRegion) const
 {
-    Q_UNUSED(repaintRegion)
+    const QRect dirtyRect = rect() & repaintRegion;
+    if (dirtyRect.isEmpty()) {
+        return;
+    }
 
     const auto *decoratedClient = client().toStrongRef().data();
 
     painter->save();
 
-    painter->fillRect(rect(), Qt::transparent);
+    painter->fillRect(dirtyRect, Qt::transparent);
     painter->setRenderHint(QPainter::Antialiasing);
     painter->setPen(Qt::NoPen);
     painter->setBrush(decoratedClient->color(
@@ -751,7 +773,7 @@ void Decoration::paintFrameBackground(QPainter *painter, const QRect &repaintReg
             : KDecoration2::ColorGroup::Inactive,
         KDecoration2::ColorRole::Frame));
     painter->setClipRect(0, borderTop(), size().width(), size().height() - borderTop(), Qt::IntersectClip);
-    painter->drawRect(rect());
+    painter->drawRect(dirtyRect);
 
     painter->restore();
 }
@@ -779,26 +801,91 @@ QColor Decoration::titleBarForegroundColor() const
     return decoratedClient->color(group, KDecoration2::ColorRole::Foreground);
 }
 
-void Decoration::paintTitleBarBackground(QPainter *painter, const QRect &repaintRegion) const
+const Decoration::ButtonColors &Decoration::buttonColors() const
+{
+    if (!m_buttonColorsDirty) {
+        return m_buttonColors;
+    }
+
+    const auto *decoratedClient = client().toStrongRef().data();
+    const QColor background = titleBarBackgroundColor();
+    const QColor foreground = titleBarForegroundColor();
+    const QColor warning = decoratedClient->color(
+        KDecoration2::ColorGroup::Warning,
+        KDecoration2::ColorRole::Foreground);
+
+    const auto mix = [&](qreal ratio) {
+        return qPremultiply(KColorUtils::mix(background, foreground, ratio).rgba());
+    };
+    const auto premultiplied = [](const QColor &color) {
+        return qPremultiply(color.rgba());
+    };
+
+    ButtonColors &colors = m_buttonColors;
+
+    // Unchecked buttons fade in a faint background on hover.
+    colors.background[NormalButtonKind][NormalButtonState] = 0;
+    colors.background[NormalButtonKind][HoveredButtonState] = mix(0.2);
+    colors.background[NormalButtonKind][PressedButtonState] = mix(0.3);
+    colors.foreground[NormalButtonKind][NormalButtonState] = mix(0.8);
+    colors.foreground[NormalButtonKind][HoveredButtonState] = premultiplied(foreground);
+    colors.foreground[NormalButtonKind][PressedButtonState] = premultiplied(foreground);
+
+    // Checked buttons are drawn inverted.
+    colors.background[CheckedButtonKind][NormalButtonState] = premultiplied(foreground);
+    colors.background[CheckedButtonKind][HoveredButtonState] = mix(0.8);
+    colors.background[CheckedButtonKind][PressedButtonState] = mix(0.7);
+    colors.foreground[CheckedButtonKind][NormalButtonState] = mix(0.2);
+    colors.foreground[CheckedButtonKind][HoveredButtonState] = premultiplied(background);
+    colors.foreground[CheckedButtonKind][PressedButtonState] = premultiplied(background);
+
+    // The close button turns red.
+    colors.background[CloseButtonKind][NormalButtonState] = 0;
+    colors.background[CloseButtonKind][HoveredButtonState] = premultiplied(warning);
+    colors.background[CloseButtonKind][PressedButtonState] = premultiplied(warning.lighter());
+    for (int state = 0; state < ButtonStateCount; ++state) {
+        colors.foreground[CloseButtonKind][state] = colors.foreground[NormalButtonKind][state];
+    }
+
+    m_buttonColorsDirty = false;
+    return m_buttonColors;
+}
+
+void Decoration::invalidateButtonColors()
 {
-    Q_UNUSED(repaintRegion)
+    m_buttonColorsDirty = true;
+}
 
+void Decoration::paintTitleBarBackground(QPainter *painter, const QRect &repaintRegion) const
+{
     const auto *decoratedClient = client().toStrongRef().data();
 
+    const QRect dirtyRect = QRect(0, 0, decoratedClient->width(), titleBarHeight()) & repaintRegion;
+    if (dirtyRect.isEmpty()) {
+        return;
+    }
+
     painter->save();
     painter->setPen(Qt::NoPen);
     painter->setBrush(titleBarBackgroundColor());
-    painter->drawRect(QRect(0, 0, decoratedClient->width(), titleBarHeight()));
+    painter->drawRect(dirtyRect);
     painter->restore();
 }
 
-void Decoration::paintCaption(QPainter *painter, const QRect &repaintRegion) const
+void Decoration::updateCaptionLayout() const
 {
-    Q_UNUSED(repaintRegion)
-
     const auto *decoratedClient = client().toStrongRef().data();
 
-    const int textWidth = settings()->fontMetrics().boundingRect(decoratedClient->caption()).width();
+    const QString caption = decoratedClient->caption();
+    const QFont font = settings()->font();
+    if (m_captionLayout.caption != caption || m_captionLayout.font != font) {
+        m_captionLayout = CaptionLayout();
+        m_captionLayout.caption = caption;
+        m_captionLayout.font = font;
+        m_captionLayout.textWidth = QFontMetrics(font).boundingRect(caption).width();
+    }
+
+    const int textWidth = m_captionLayout.textWidth;
     const QRect textRect((size().width() - textWidth) / 2, 0, textWidth, titleBarHeight());
 
     const QRect titleBarRect(0, 0, size().width(), titleBarHeight());
@@ -854,11 +941,84 @@ void Decoration::paintCaption(QPainter *painter, const QRect &repaintRegion) con
             break;
     }
 
-    const QString caption = painter->fontMetrics().elidedText(
-        decoratedClient->caption(), Qt::ElideMiddle, captionRect.width());
+    // Elide and shape the caption only when the space it gets changes.
+    if (m_captionLayout.availableWidth != captionRect.width()
+            || m_captionLayout.alignment != alignment) {
+        const QString elidedCaption = QFontMetrics(font).elidedText(
+            caption, Qt::ElideMiddle, captionRect.width());
+
+        m_captionLayout.availableWidth = captionRect.width();
+        m_captionLayout.alignment = alignment;
+        m_captionLayout.text.setTextFormat(Qt::PlainText);
+        m_captionLayout.text.setText(elidedCaption);
+        m_captionLayout.text.prepare(QTransform(), font);
+    }
+
+    // The caption rect may span the whole title bar, the bounds only
+    // cover the text drawn into it.
+    m_captionLayout.textRect = textRect;
+    m_captionLayout.bounds = QStyle::alignedRect(Qt::LeftToRight, alignment,
+        m_captionLayout.text.size().toSize(), captionRect);
+}
+
+int Decoration::captionUpdateInterval() const
+{
+    // Never more than once per frame, and no faster than the configured
+    // rate for windows the user isn't looking at.
+    int interval = AnimationDriver::frameInterval();
+
+    const auto *decoratedClient = client().toStrongRef().data();
+    if (!decoratedClient->isActive()) {
+        interval = qMax(interval, 1000 / qMax(1, m_internalSettings->inactiveCaptionRate()));
+    }
+    return interval;
+}
+
+void Decoration::scheduleCaptionUpdate()
+{
+    // The pending update reads the caption when it fires, so the last
+    // caption is always the one shown.
+    if (m_captionTimer.isActive()) {
+        return;
+    }
+
+    const qint64 elapsed = m_captionUpdateClock.isValid()
+        ? m_captionUpdateClock.elapsed()
+        : std::numeric_limits<qint64>::max();
+    const qint64 interval = captionUpdateInterval();
+    if (elapsed >= interval) {
+        updateCaption();
+    } else {
+        m_captionTimer.start(int(interval - elapsed));
+    }
+}
+
+void Decoration::updateCaption()
+{
+    m_captionUpdateClock.start();
+
+    // Only the old and the new caption text need repainting.
+    const QRect oldBounds = m_captionLayout.bounds;
+    updateCaptionLayout();
+    invalidateTitleBarLayer();
+    update(oldBounds | m_captionLayout.bounds);
+}
+
+void Decoration::paintCaption(QPainter *painter, const QRect &repaintRegion) const
+{
+    updateCaptionLayout();
+
+    const QRect &captionBounds = m_captionLayout.bounds;
+    if (!captionBounds.intersects(repaintRegion)) {
+        return;
+    }
+
+    const QFont &font = m_captionLayout.font;
+    const int textWidth = m_captionLayout.textWidth;
+    const QRect &textRect = m_captionLayout.textRect;
 
     painter->save();
-    painter->setFont(settings()->font());
+    painter->setFont(font);
 
     if (m_menuButtons->buttons().isEmpty()) {
         painter->setPen(titleBarForegroundColor());
@@ -868,8 +1028,7 @@ void Decoration::paintCaption(QPainter *painter, const QRect &repaintRegion) con
         const int textRight = textRect.right();
         // qCDebug(category) << "textLeft" << textLeft << "menuRight" << menuRight;
 
-        if (!m_menuButtons->alwaysShow()) { // caption fades away revealing menu
-            painter->setOpacity(1.0 - m_menuButtons->opacity());
+        if (!m_menuButtons->alwaysShow()) { // caption fades away revealing menu, see paintTitleBarLayer()
             painter->setPen(titleBarForegroundColor());
         } else if (m_menuButtons->overflowing()) { // hide caption leaving "whitespace" to easily grab.
             painter->setPen(Qt::transparent);
@@ -893,15 +1052,29 @@ void Decoration::paintCaption(QPainter *painter, const QRect &repaintRegion) con
         }
     }
 
-    painter->drawText(captionRect, alignment, caption);
+    painter->drawStaticText(captionBounds.topLeft(), m_captionLayout.text);
     painter->restore();
 }
 
 void Decoration::paintButtons(QPainter *painter, const QRect &repaintRegion) const
 {
-    m_leftButtons->paint(painter, repaintRegion);
-    m_rightButtons->paint(painter, repaintRegion);
-    m_menuButtons->paint(painter, repaintRegion);
+    const auto isDirty = [&repaintRegion](const KDecoration2::DecorationButtonGroup *group) {
+        return !group->buttons().isEmpty()
+            && repaintRegion.intersects(group->geometry().toAlignedRect());
+    };
+
+    if (isDirty(m_leftButtons)) {
+        m_leftButtons->paint(painter, repaintRegion);
+    }
+    if (isDirty(m_rightButtons)) {
+        m_rightButtons->paint(painter, repaintRegion);
+    }
+
+    // Hidden until hovered unless MenuAlwaysShow is set, which leaves most
+    // menus fully transparent.
+    if (m_menuButtons->opacity() > 0 && isDirty(m_menuButtons)) {
+        m_menuButtons->paint(painter, repaintRegion);
+    }
 }
 
 } // namespace Material
@@ -21,6 +21,7 @@
 // own
 #include "AppMenuButtonGroup.h"
 #include "InternalSettings.h"
+#include "ShadowCache.h"
 
 // KDecoration
 #include <KDecoration2/Decoration>
@@ -28,9 +29,16 @@
 #include <KDecoration2/DecorationButtonGroup>
 
 // Qt
+#include <QFont>
+#include <QHash>
+#include <QElapsedTimer>
 #include <QHoverEvent>
+#include <QImage>
+#include <QRgb>
 #include <QMouseEvent>
 #include <QSharedPointer>
+#include <QStaticText>
+#include <QTimer>
 #include <QWheelEvent>
 #include <QVariant>
 
@@ -81,6 +89,12 @@ private:
     void setButtonGroupAnimation(KDecoration2::DecorationButtonGroup *buttonGroup, bool enabled, int duration);
     void updateButtonAnimation();
     void updateShadow();
+    void scheduleCaptionUpdate();
+    void updateCaption();
+    int captionUpdateInterval() const;
+    void invalidateTitleBarLayer();
+    bool captionFadesWithMenu() const;
+    QRect menuFadeRect() const;
 
     bool animationsEnabled() const;
     int animationsDuration() const;
@@ -91,6 +105,7 @@ private:
 
     bool titleBarIsHovered() const;
     int getTextWidth(const QString text, bool showMnemonic = false) const;
+    void resetFontMetrics();
     QPoint windowPos() const;
 
     void initDragMove(const QPoint pos);
@@ -101,16 +116,80 @@ private:
     QColor titleBarBackgroundColor() const;
     QColor titleBarForegroundColor() const;
 
+    // Premultiplied button colors, indexed by kind and state. Animations
+    // blend from the normal color towards the hovered or pressed one.
+    enum ButtonKind {
+        NormalButtonKind,
+        CheckedButtonKind,
+        CloseButtonKind,
+        ButtonKindCount
+    };
+    enum ButtonState {
+        NormalButtonState,
+        HoveredButtonState,
+        PressedButtonState,
+        ButtonStateCount
+    };
+    struct ButtonColors
+    {
+        QRgb background[ButtonKindCount][ButtonStateCount];
+        QRgb foreground[ButtonKindCount][ButtonStateCount];
+    };
+    const ButtonColors &buttonColors() const;
+    void invalidateButtonColors();
+
     void paintFrameBackground(QPainter *painter, const QRect &repaintRegion) const;
+    void paintTitleBarLayer(QPainter *painter, const QRect &repaintRegion);
     void paintTitleBarBackground(QPainter *painter, const QRect &repaintRegion) const;
     void paintCaption(QPainter *painter, const QRect &repaintRegion) const;
+    void updateCaptionLayout() const;
     void paintButtons(QPainter *painter, const QRect &repaintRegion) const;
 
+    // The measured caption and its elided, shaped text. The width is kept
+    // until the caption or font changes, the text until the space it's
+    // given or its alignment changes as well.
+    struct CaptionLayout
+    {
+        QString caption;
+        QFont font;
+        int textWidth = 0;
+
+        int availableWidth = -1;
+        Qt::Alignment alignment;
+        QStaticText text;
+
+        QRect textRect; // where the unelided text would be centered
+        QRect bounds;   // where the elided text is drawn
+    };
+
     KDecoration2::DecorationButtonGroup *m_leftButtons;
     KDecoration2::DecorationButtonGroup *m_rightButtons;
     AppMenuButtonGroup *m_menuButtons;
 
     QSharedPointer<InternalSettings> m_internalSettings;
+    qreal m_devicePixelRatio;
+    ShadowKey m_shadowKey;
+
+    // Title bar background and caption, rendered at m_devicePixelRatio.
+    // A caption that fades with the menu is kept in its own layer and
+    // blended on top, so menu fades don't rebuild either of them.
+    QImage m_titleBarLayer;
+    QImage m_captionLayer;
+    bool m_titleBarLayerDirty = true;
+    mutable CaptionLayout m_captionLayout;
+
+    // Rebuilt after palette, active state or opacity changes.
+    mutable ButtonColors m_buttonColors;
+    mutable bool m_buttonColorsDirty = true;
+
+    // Coalesces caption changes of clients that retitle constantly.
+    QTimer m_captionTimer;
+    QElapsedTimer m_captionUpdateClock;
+
+    // Measurements in settings()->font(), dropped on reconfigure. Text
+    // widths are kept apart for hidden and shown mnemonics.
+    mutable int m_fontHeight = -1;
+    mutable QHash<QString, int> m_textWidths[2];
 
     QPoint m_pressedPoint;
     xcb_atom_t m_moveResizeAtom = 0;
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "GlyphAtlas.h"
+
+// Qt
+#include <QPainter>
+
+namespace Material
+{
+
+namespace
+{
+// Glyphs are a few hundred bytes each, 1 MiB holds every button at
+// several sizes and ratios.
+const int s_maxCostBytes = 1024 * 1024;
+
+inline QRgb scaled(QRgb color, uint coverage)
+{
+    const auto scale = [coverage](uint channel) {
+        return (channel * coverage + 127) / 255;
+    };
+    return qRgba(scale(qRed(color)), scale(qGreen(color)), scale(qBlue(color)), scale(qAlpha(color)));
+}
+} // anonymous namespace
+
+bool GlyphKey::operator==(const GlyphKey &other) const
+{
+    return type == other.type
+        && checked == other.checked
+        && iconSize == other.iconSize
+        && qFuzzyCompare(devicePixelRatio, other.devicePixelRatio)
+        && subpixelX == other.subpixelX
+        && subpixelY == other.subpixelY;
+}
+
+bool GlyphKey::operator!=(const GlyphKey &other) const
+{
+    return !(*this == other);
+}
+
+uint qHash(const GlyphKey &key, uint seed)
+{
+    // Round the ratio so keys that compare equal also hash equal.
+    const int dpr = qRound(key.devicePixelRatio * 100);
+    return ::qHash(key.type, seed)
+        ^ ::qHash(uint(key.checked), seed) << 6
+        ^ ::qHash(key.iconSize, seed) << 8
+        ^ ::qHash(dpr, seed) << 16
+        ^ ::qHash(key.subpixelX << 2 | key.subpixelY, seed) << 26;
+}
+
+GlyphAtlas &GlyphAtlas::self()
+{
+    static GlyphAtlas atlas;
+    return atlas;
+}
+
+GlyphAtlas::GlyphAtlas()
+    : m_glyphs(s_maxCostBytes)
+{
+}
+
+QImage GlyphAtlas::glyph(const GlyphKey &key, const QSize &size, const Rasterizer &rasterize)
+{
+    if (const QImage *cached = m_glyphs.object(key)) {
+        return *cached;
+    }
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    rasterize(&painter);
+    painter.end();
+
+    QImage coverage = image.convertToFormat(QImage::Format_Alpha8);
+    coverage.setDevicePixelRatio(key.devicePixelRatio);
+    m_glyphs.insert(key, new QImage(coverage), static_cast<int>(coverage.sizeInBytes()));
+    return coverage;
+}
+
+void GlyphAtlas::draw(QPainter *painter, const QPointF &pos, const QImage &glyph, const QColor &color)
+{
+    const int width = glyph.width();
+    const int height = glyph.height();
+    const QRgb rgb = qPremultiply(color.rgba());
+
+    if (m_tinted.size() < width * height) {
+        m_tinted.resize(width * height);
+    }
+    QRgb *bits = m_tinted.data();
+    for (int y = 0; y < height; ++y) {
+        const uchar *coverage = glyph.constScanLine(y);
+        QRgb *line = bits + y * width;
+        for (int x = 0; x < width; ++x) {
+            line[x] = coverage[x] ? scaled(rgb, coverage[x]) : 0;
+        }
+    }
+
+    QImage tinted(reinterpret_cast<uchar *>(bits), width, height,
+        width * int(sizeof(QRgb)), QImage::Format_ARGB32_Premultiplied);
+    tinted.setDevicePixelRatio(glyph.devicePixelRatio());
+    painter->drawImage(pos, tinted);
+}
+
+void GlyphAtlas::clear()
+{
+    m_glyphs.clear();
+    m_tinted = QVector<QRgb>();
+}
+
+} // namespace Material
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QCache>
+#include <QColor>
+#include <QImage>
+#include <QPointF>
+#include <QVector>
+
+// std
+#include <functional>
+
+class QPainter;
+
+namespace Material
+{
+
+// Everything the coverage of a button glyph depends on. The color isn't
+// part of it, glyphs are tinted when they're drawn.
+struct GlyphKey
+{
+    int type = 0; // KDecoration2::DecorationButtonType
+    bool checked = false;
+    int iconSize = 0;
+    qreal devicePixelRatio = 1;
+    int subpixelX = 0; // quarter device pixels
+    int subpixelY = 0;
+
+    bool operator==(const GlyphKey &other) const;
+    bool operator!=(const GlyphKey &other) const;
+};
+
+uint qHash(const GlyphKey &key, uint seed = 0);
+
+// Process-wide cache of rasterized button glyphs, shared by all
+// decorations. Glyphs are kept as 8-bit coverage, so hover animations
+// that step through colors all reuse the same entry.
+class GlyphAtlas
+{
+public:
+    using Rasterizer = std::function<void(QPainter *painter)>;
+
+    static GlyphAtlas &self();
+
+    // The coverage of the glyph, `size` device pixels large. On a miss
+    // `rasterize` strokes the glyph in opaque black onto a transparent
+    // image of that size, with the painter in device pixels.
+    QImage glyph(const GlyphKey &key, const QSize &size, const Rasterizer &rasterize);
+
+    // Draws `glyph` tinted with `color`, its top left corner at `pos`.
+    void draw(QPainter *painter, const QPointF &pos, const QImage &glyph, const QColor &color);
+
+    void clear();
+
+private:
+    GlyphAtlas();
+
+    QCache<GlyphKey, QImage> m_glyphs;
+
+    // The tinted glyph of draw(). Buttons are painted on the GUI thread
+    // only, so one buffer the size of the largest glyph does.
+    QVector<QRgb> m_tinted;
+};
+
+} // namespace Material
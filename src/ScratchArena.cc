@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "ScratchArena.h"
+
+// std
+#include <atomic>
+
+namespace Material
+{
+
+namespace
+{
+// Bumped by releaseAll(). A buffer last sized in an older generation is
+// freed before it's handed out again.
+std::atomic<int> s_generation(0);
+} // anonymous namespace
+
+ScratchArena &ScratchArena::local()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+void ScratchArena::releaseAll()
+{
+    ++s_generation;
+
+    ScratchArena &arena = local();
+    for (std::vector<uchar> &buffer : arena.m_buffers) {
+        std::vector<uchar>().swap(buffer);
+    }
+}
+
+uchar *ScratchArena::buffer(Buffer which, size_t size)
+{
+    std::vector<uchar> &buffer = m_buffers[which];
+
+    const int generation = s_generation.load(std::memory_order_relaxed);
+    if (m_generations[which] != generation) {
+        m_generations[which] = generation;
+        std::vector<uchar>().swap(buffer);
+    }
+
+    if (buffer.size() < size) {
+        buffer.resize(size);
+    }
+    return buffer.data();
+}
+
+size_t ScratchArena::capacity() const
+{
+    size_t bytes = 0;
+    for (const std::vector<uchar> &buffer : m_buffers) {
+        bytes += buffer.capacity();
+    }
+    return bytes;
+}
+
+} // namespace Material
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Qt
+#include <QtGlobal>
+
+// std
+#include <vector>
+
+namespace Material
+{
+
+// Per-thread scratch memory for the shadow pipeline. Temporaries are
+// carved out of buffers that grow to the largest request and are then
+// reused, so blurring the same geometry again doesn't touch the heap for
+// them. Nothing is allocated up front, and releaseAll() hands the memory
+// back when the shadows are thrown away.
+class ScratchArena
+{
+public:
+    enum Buffer {
+        Transposed, // the transposed plane of boxBlurAlpha()
+        Weights,    // the column weights of a separable plane
+        Columns,    // the column profile of a plane
+        Rows,       // the row profile of a plane
+        Kernel,     // the taps of an ExactGaussian kernel
+        Temporary,  // a profile being blurred, prefix sums or a row of coverage
+        BufferCount
+    };
+
+    // The arena of the calling thread.
+    static ScratchArena &local();
+
+    // Frees the buffers of every thread. The calling thread's go right
+    // away, other threads drop theirs the next time they ask for them.
+    static void releaseAll();
+
+    // At least `size` bytes, valid until the same buffer is requested
+    // again on this thread.
+    uchar *buffer(Buffer which, size_t size);
+
+    template <typename T>
+    T *buffer(Buffer which, int count)
+    {
+        return reinterpret_cast<T *>(buffer(which, count * sizeof(T)));
+    }
+
+    // Bytes held by this thread's buffers.
+    size_t capacity() const;
+
+private:
+    ScratchArena() = default;
+
+    std::vector<uchar> m_buffers[BufferCount];
+    int m_generations[BufferCount] = {};
+};
+
+} // namespace Material
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "ShadowCache.h"
+#include "Material.h"
+#include "ScratchArena.h"
+#include "ShadowDiskCache.h"
+#include "ShadowRenderer.h"
+
+// Qt
+#include <QDebug>
+#include <QtConcurrent>
+
+// std
+#include <atomic>
+
+namespace Material
+{
+
+namespace
+{
+// 32 MiB of textures, enough for every preset at a few device pixel ratios.
+const int s_maxCostKiB = 32 * 1024;
+
+QSharedPointer<KDecoration2::DecorationShadow> createShadow(const ShadowTexture &texture)
+{
+    if (texture.isNull()) {
+        return {};
+    }
+    auto shadow = QSharedPointer<KDecoration2::DecorationShadow>::create();
+    shadow->setPadding(texture.padding);
+    shadow->setInnerShadowRect(texture.innerShadowRect);
+    shadow->setShadow(texture.image);
+    return shadow;
+}
+
+// Bumped by clear(). Renders requested in an older generation give up
+// instead of caching planes nobody asked for anymore.
+std::atomic<int> s_generation(0);
+
+// Runs on a worker thread. Only the blur is worth caching on disk, the
+// tint pass is cheap.
+ShadowTexture loadOrRender(const ShadowKey &key, int generation)
+{
+    auto abandoned = [generation] {
+        return generation != s_generation.load(std::memory_order_relaxed);
+    };
+
+    ShadowRenderer::ShadowGeometry geometry = ShadowRenderer::cachedGeometry(key);
+    if (geometry.isNull()) {
+        geometry = ShadowDiskCache::load(key);
+        if (geometry.isNull() && !abandoned()) {
+            geometry = ShadowRenderer::blur(key);
+            if (!abandoned()) {
+                ShadowDiskCache::store(key, geometry);
+            }
+        }
+        if (abandoned()) {
+            return {};
+        }
+        ShadowRenderer::cacheGeometry(key, geometry);
+    }
+    if (abandoned()) {
+        return {};
+    }
+    return ShadowRenderer::tint(key, geometry);
+}
+} // anonymous namespace
+
+bool ShadowKey::operator==(const ShadowKey &other) const
+{
+    return preset == other.preset
+        && quality == other.quality
+        && cornerRadius == other.cornerRadius
+        && color == other.color
+        && strength == other.strength
+        && qFuzzyCompare(devicePixelRatio, other.devicePixelRatio);
+}
+
+bool ShadowKey::operator!=(const ShadowKey &other) const
+{
+    return !(*this == other);
+}
+
+uint qHash(const ShadowKey &key, uint seed)
+{
+    // Round the ratio so keys that compare equal also hash equal.
+    const int dpr = qRound(key.devicePixelRatio * 100);
+    return ::qHash(key.preset, seed)
+        ^ ::qHash(key.quality, seed) << 4
+        ^ ::qHash(key.cornerRadius, seed) << 12
+        ^ ::qHash(key.color, seed)
+        ^ ::qHash(key.strength, seed) << 8
+        ^ ::qHash(dpr, seed) << 16;
+}
+
+ShadowCache &ShadowCache::self()
+{
+    static ShadowCache cache;
+    return cache;
+}
+
+ShadowCache::ShadowCache()
+    : m_cache(s_maxCostKiB)
+    , m_hits(0)
+    , m_misses(0)
+{
+}
+
+ShadowCache::~ShadowCache()
+{
+    clear();
+    // Abandoned renders still run code of this plugin, m_pool's destructor
+    // waits for them.
+}
+
+QSharedPointer<KDecoration2::DecorationShadow> ShadowCache::shadow(const ShadowKey &key)
+{
+    const auto *cached = m_cache.object(key);
+    if (!cached) {
+        ++m_misses;
+        qCDebug(category) << "ShadowCache miss" << m_misses << "hits" << m_hits;
+        return {};
+    }
+    ++m_hits;
+    return *cached;
+}
+
+void ShadowCache::insert(const ShadowKey &key, const QSharedPointer<KDecoration2::DecorationShadow> &shadow)
+{
+    if (shadow.isNull()) {
+        return;
+    }
+    const int cost = qMax(1, static_cast<int>(shadow->shadow().sizeInBytes() / 1024));
+    m_cache.insert(key, new QSharedPointer<KDecoration2::DecorationShadow>(shadow), cost);
+}
+
+QSharedPointer<KDecoration2::DecorationShadow> ShadowCache::retint(const ShadowKey &key)
+{
+    const auto shadow = createShadow(ShadowRenderer::retint(key));
+    insert(key, shadow);
+    return shadow;
+}
+
+void ShadowCache::request(const ShadowKey &key)
+{
+    if (m_pending.contains(key)) {
+        return;
+    }
+
+    auto *watcher = new QFutureWatcher<ShadowTexture>(this);
+    m_pending.insert(key, watcher);
+
+    connect(watcher, &QFutureWatcher<ShadowTexture>::finished, this, [this, key, watcher] {
+        m_pending.remove(key);
+        watcher->deleteLater();
+
+        const auto shadow = createShadow(watcher->result());
+        insert(key, shadow);
+        emit shadowReady(key, shadow);
+    });
+
+    watcher->setFuture(QtConcurrent::run(&m_pool, &loadOrRender, key,
+                                         s_generation.load(std::memory_order_relaxed)));
+}
+
+QSharedPointer<KDecoration2::DecorationShadow> ShadowCache::placeholder(const ShadowKey &key) const
+{
+    // Quality, corner radius and strength change the padding or the look
+    // of the shadow as much as the preset does, so only the color may
+    // differ. Without such a shadow, showing none is better than a wrong one.
+    const auto keys = m_cache.keys();
+    for (const ShadowKey &other : keys) {
+        if (other.preset == key.preset
+                && other.quality == key.quality
+                && other.cornerRadius == key.cornerRadius
+                && other.strength == key.strength
+                && qFuzzyCompare(other.devicePixelRatio, key.devicePixelRatio)) {
+            return *m_cache.object(other);
+        }
+    }
+    return {};
+}
+
+void ShadowCache::clear()
+{
+    // This runs on the GUI thread when the last decoration goes away, so
+    // don't wait for a render that may take a while. Queued ones are
+    // dropped, running ones give up at their next step, and their results
+    // are never delivered.
+    ++s_generation;
+    m_pool.clear();
+    qDeleteAll(m_pending);
+    m_pending.clear();
+    m_cache.clear();
+    ShadowRenderer::clearCache();
+    ScratchArena::releaseAll();
+}
+
+int ShadowCache::hits() const
+{
+    return m_hits;
+}
+
+int ShadowCache::misses() const
+{
+    return m_misses;
+}
+
+} // namespace Material
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// KDecoration
+#include <KDecoration2/DecorationShadow>
+
+// Qt
+#include <QCache>
+#include <QColor>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+namespace Material
+{
+
+// Everything a shadow texture depends on. Active and inactive windows
+// share their shadow, so the window state isn't part of it.
+struct ShadowKey
+{
+    int preset = 0; // InternalSettings::EnumShadowSize
+    int quality = 0; // InternalSettings::EnumShadowQuality
+    int cornerRadius = 0;
+    QRgb color = 0;
+    int strength = 255;
+    qreal devicePixelRatio = 1;
+
+    bool operator==(const ShadowKey &other) const;
+    bool operator!=(const ShadowKey &other) const;
+};
+
+uint qHash(const ShadowKey &key, uint seed = 0);
+
+struct ShadowTexture;
+
+// Process-wide LRU cache of finished shadows, shared by all decorations.
+// Its cost is the texture size in KiB, so a few HiDPI variants don't push
+// out many small ones.
+//
+// Missing shadows are rendered on a worker pool. Requests for a shadow
+// that is already being rendered are merged, and every decoration waiting
+// for it is told through shadowReady().
+class ShadowCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ShadowCache &self();
+
+    // Returns a null pointer on a miss.
+    QSharedPointer<KDecoration2::DecorationShadow> shadow(const ShadowKey &key);
+    void insert(const ShadowKey &key, const QSharedPointer<KDecoration2::DecorationShadow> &shadow);
+
+    // Builds the shadow right away if one with the same geometry was
+    // rendered before, so only a tint pass is needed. Returns a null
+    // pointer otherwise.
+    QSharedPointer<KDecoration2::DecorationShadow> retint(const ShadowKey &key);
+
+    // Renders the shadow for `key` in the background, unless that is
+    // already in progress. shadowReady() is emitted on the GUI thread.
+    void request(const ShadowKey &key);
+
+    // A cached shadow that only differs from `key` in its color, to show
+    // while the right one is being rendered.
+    QSharedPointer<KDecoration2::DecorationShadow> placeholder(const ShadowKey &key) const;
+
+    // Abandons the renders in progress, then drops every cached shadow and
+    // the scratch memory they were built in.
+    void clear();
+
+    int hits() const;
+    int misses() const;
+
+signals:
+    void shadowReady(const ShadowKey &key, const QSharedPointer<KDecoration2::DecorationShadow> &shadow);
+
+private:
+    ShadowCache();
+    ~ShadowCache() override;
+
+    QCache<ShadowKey, QSharedPointer<KDecoration2::DecorationShadow>> m_cache;
+    QHash<ShadowKey, QFutureWatcher<ShadowTexture> *> m_pending;
+    QThreadPool m_pool;
+    int m_hits;
+    int m_misses;
+};
+
+} // namespace Material
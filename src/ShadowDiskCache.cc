@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "ShadowDiskCache.h"
+#include "Material.h"
+
+// Qt
+#include <QAtomicInt>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// std
+#include <cstring>
+
+namespace Material
+{
+namespace ShadowDiskCache
+{
+
+namespace
+{
+
+const quint32 s_magic = 0x4853444d; // "MDSH"
+const quint32 s_formatVersion = 5;
+
+// Entries beyond this are pruned, least recently used first. Loading an
+// entry touches it, so its modification time is the time of last use.
+const int s_maxEntries = 64;
+
+// Every shadow is built from two layers.
+const int s_layerCount = 2;
+
+// The planes follow the header directly, one after the other. The header
+// is a multiple of 16 bytes and every plane a multiple of 4, so the rows
+// stay aligned for QImage.
+struct Header
+{
+    quint32 magic;
+    quint32 formatVersion;
+    quint32 generatorVersion;
+    quint32 checksum; // of the header, with this field zeroed
+
+    // The key, to catch file name collisions.
+    qint32 preset;
+    qint32 quality;
+    qint32 cornerRadius;
+    qint32 devicePixelRatio; // in percent
+
+    qint32 width;
+    qint32 height;
+    qint32 padding[4];
+    qint32 mask[4];
+    qint32 stretch[4];
+
+    struct Layer
+    {
+        qint32 x;
+        qint32 y;
+        qint32 width;
+        qint32 height;
+        qint32 bytesPerLine;
+    } layers[s_layerCount];
+
+    qint32 reserved[4];
+};
+static_assert(sizeof(Header) % 16 == 0, "Header must keep the planes aligned");
+
+QString cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+        + QStringLiteral("/material-decoration/shadows");
+}
+
+// Only the geometry, the color and strength are tinted in after loading.
+QString filePath(const ShadowKey &key)
+{
+    return cacheDirectory() + QLatin1Char('/') + QString::asprintf("%d-%d-%d-%d.shadow",
+        key.preset,
+        key.quality,
+        key.cornerRadius,
+        qRound(key.devicePixelRatio * 100));
+}
+
+Header headerFor(const ShadowKey &key)
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = s_magic;
+    header.formatVersion = s_formatVersion;
+    header.generatorVersion = ShadowRenderer::generatorVersion;
+    header.preset = key.preset;
+    header.quality = key.quality;
+    header.cornerRadius = key.cornerRadius;
+    header.devicePixelRatio = qRound(key.devicePixelRatio * 100);
+    return header;
+}
+
+// FNV-1a over the header, good enough to notice scribbled-over files.
+// Truncated ones are caught by their size. The planes aren't checked, that
+// would read all of them on every load.
+quint32 checksum(Header header)
+{
+    header.checksum = 0;
+    const auto *data = reinterpret_cast<const uchar *>(&header);
+    quint32 hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(header); ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+QRect toRect(const qint32 (&rect)[4])
+{
+    return QRect(rect[0], rect[1], rect[2], rect[3]);
+}
+
+void fromRect(qint32 (&rect)[4], const QRect &value)
+{
+    rect[0] = value.x();
+    rect[1] = value.y();
+    rect[2] = value.width();
+    rect[3] = value.height();
+}
+
+// All planes borrow the same mapping, which goes away with the last one.
+struct Mapping
+{
+    explicit Mapping(const QString &fileName)
+        : file(fileName)
+        , ref(s_layerCount)
+    {
+    }
+
+    QFile file;
+    QAtomicInt ref;
+};
+
+void releaseMapping(void *mapping)
+{
+    auto *shared = static_cast<Mapping *>(mapping);
+    if (!shared->ref.deref()) {
+        delete shared;
+    }
+}
+
+void prune(const QDir &dir)
+{
+    const QFileInfoList entries = dir.entryInfoList(
+        QStringList{QStringLiteral("*.shadow")}, QDir::Files, QDir::Time);
+    for (int i = s_maxEntries; i < entries.size(); ++i) {
+        QFile::remove(entries.at(i).absoluteFilePath());
+    }
+}
+
+} // anonymous namespace
+
+ShadowRenderer::ShadowGeometry load(const ShadowKey &key)
+{
+    auto *mapping = new Mapping(filePath(key));
+    QFile &file = mapping->file;
+    if (!file.open(QIODevice::ReadOnly)) {
+        delete mapping;
+        return {};
+    }
+
+    const qint64 size = file.size();
+    const uchar *data = size >= qint64(sizeof(Header)) ? file.map(0, size) : nullptr;
+    if (!data) {
+        delete mapping;
+        return {};
+    }
+
+    const Header expected = headerFor(key);
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+
+    bool valid = header.magic == expected.magic
+        && header.formatVersion == expected.formatVersion
+        && header.generatorVersion == expected.generatorVersion
+        && header.checksum == checksum(header)
+        && header.preset == expected.preset
+        && header.quality == expected.quality
+        && header.cornerRadius == expected.cornerRadius
+        && header.devicePixelRatio == expected.devicePixelRatio
+        && header.width > 0 && header.height > 0
+        && QRect(0, 0, header.width, header.height).contains(toRect(header.stretch));
+
+    qint64 expectedSize = sizeof(Header);
+    for (const Header::Layer &layer : header.layers) {
+        valid = valid
+            && layer.width > 0 && layer.height > 0
+            && layer.bytesPerLine >= layer.width && layer.bytesPerLine % 4 == 0;
+        expectedSize += qint64(layer.bytesPerLine) * layer.height;
+    }
+    valid = valid && size == expectedSize;
+
+    if (!valid) {
+        qCDebug(category) << "Dropping stale shadow cache entry" << file.fileName();
+        file.remove();
+        delete mapping;
+        return {};
+    }
+
+    // Keep the entry from being pruned while it's in use.
+    file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+
+    ShadowRenderer::ShadowGeometry geometry;
+    geometry.size = QSize(header.width, header.height);
+    geometry.padding = QMargins(header.padding[0], header.padding[1],
+                                header.padding[2], header.padding[3]);
+    geometry.mask = toRect(header.mask);
+    geometry.stretch = toRect(header.stretch);
+
+    // The planes borrow the mapping. The const constructor makes QImage
+    // copy before any write.
+    const uchar *plane = data + sizeof(Header);
+    for (const Header::Layer &layer : header.layers) {
+        BoxShadowHelper::ShadowLayer shadowLayer;
+        shadowLayer.alpha = QImage(plane, layer.width, layer.height, layer.bytesPerLine,
+                                   QImage::Format_Alpha8, releaseMapping, mapping);
+        shadowLayer.topLeft = QPoint(layer.x, layer.y);
+        geometry.layers.append(shadowLayer);
+        plane += qint64(layer.bytesPerLine) * layer.height;
+    }
+    return geometry;
+}
+
+void store(const ShadowKey &key, const ShadowRenderer::ShadowGeometry &geometry)
+{
+    if (geometry.layers.size() != s_layerCount) {
+        return;
+    }
+    for (const auto &layer : geometry.layers) {
+        if (layer.alpha.format() != QImage::Format_Alpha8) {
+            return;
+        }
+    }
+
+    const QDir dir(cacheDirectory());
+    if (!dir.mkpath(QStringLiteral("."))) {
+        return;
+    }
+
+    Header header = headerFor(key);
+    header.width = geometry.size.width();
+    header.height = geometry.size.height();
+    header.padding[0] = geometry.padding.left();
+    header.padding[1] = geometry.padding.top();
+    header.padding[2] = geometry.padding.right();
+    header.padding[3] = geometry.padding.bottom();
+    fromRect(header.mask, geometry.mask);
+    fromRect(header.stretch, geometry.stretch);
+    for (int i = 0; i < s_layerCount; ++i) {
+        const BoxShadowHelper::ShadowLayer &layer = geometry.layers.at(i);
+        header.layers[i].x = layer.topLeft.x();
+        header.layers[i].y = layer.topLeft.y();
+        header.layers[i].width = layer.alpha.width();
+        header.layers[i].height = layer.alpha.height();
+        header.layers[i].bytesPerLine = layer.alpha.bytesPerLine();
+    }
+    header.checksum = checksum(header);
+
+    // QSaveFile writes to a temporary and renames it, so a crash or a
+    // second KWin never leaves a half written entry behind.
+    QSaveFile file(filePath(key));
+    bool written = file.open(QIODevice::WriteOnly)
+        && file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == qint64(sizeof(header));
+    for (const auto &layer : geometry.layers) {
+        const qint64 planeBytes = qint64(layer.alpha.bytesPerLine()) * layer.alpha.height();
+        written = written
+            && file.write(reinterpret_cast<const char *>(layer.alpha.constBits()), planeBytes) == planeBytes;
+    }
+    if (!written || !file.commit()) {
+        qCDebug(category) << "Couldn't write shadow cache entry" << file.fileName();
+        return;
+    }
+
+    prune(dir);
+}
+
+} // namespace ShadowDiskCache
+} // namespace Material
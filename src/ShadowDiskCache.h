@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// own
+#include "ShadowCache.h"
+#include "ShadowRenderer.h"
+
+namespace Material
+{
+namespace ShadowDiskCache
+{
+
+// The blurred planes of finished shadows are kept under the user's cache
+// directory, so a restarted KWin can map them instead of blurring again.
+// Entries only depend on the geometry, the color and strength are tinted
+// in afterwards, so trying out colors doesn't add any. Both functions are
+// safe to call from worker threads.
+
+// Returns a null geometry if there is no valid entry for `key`. Broken or
+// stale entries are removed.
+ShadowRenderer::ShadowGeometry load(const ShadowKey &key);
+void store(const ShadowKey &key, const ShadowRenderer::ShadowGeometry &geometry);
+
+} // namespace ShadowDiskCache
+} // namespace Material
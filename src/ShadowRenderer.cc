@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "ShadowRenderer.h"
+#include "BoxShadowHelper.h"
+#include "InternalSettings.h"
+
+// Qt
+#include <QCache>
+#include <QMutex>
+
+// std
+#include <cstring>
+
+namespace Material
+{
+namespace ShadowRenderer
+{
+
+namespace
+{
+
+// const CompositeShadowParams s_shadowParams = CompositeShadowParams(
+//     QPoint(0, 18),
+//     ShadowParams(QPoint(0, 0), 64, 0.8),
+//     ShadowParams(QPoint(0, -10), 24, 0.1)
+// );
+constexpr CompositeShadowParams s_shadowParams[] = {
+    // None
+    CompositeShadowParams(),
+    // Small
+    CompositeShadowParams(
+        QPoint(0, 4),
+        ShadowParams(QPoint(0, 0), 16, 1),
+        ShadowParams(QPoint(0, -2), 8, 0.4)),
+    // Medium
+    CompositeShadowParams(
+        QPoint(0, 8),
+        ShadowParams(QPoint(0, 0), 32, 0.9),
+        ShadowParams(QPoint(0, -4), 16, 0.3)),
+    // Large
+    CompositeShadowParams(
+        QPoint(0, 12),
+        ShadowParams(QPoint(0, 0), 48, 0.8),
+        ShadowParams(QPoint(0, -6), 24, 0.2)),
+    // Very large
+    CompositeShadowParams(
+        QPoint(0, 16),
+        ShadowParams(QPoint(0, 0), 64, 0.7),
+        ShadowParams(QPoint(0, -8), 32, 0.1)),
+};
+
+} // anonymous namespace
+
+CompositeShadowParams lookupShadowParams(int size)
+{
+    switch (size) {
+    case InternalSettings::ShadowNone:
+        return s_shadowParams[0];
+    case InternalSettings::ShadowSmall:
+        return s_shadowParams[1];
+    case InternalSettings::ShadowMedium:
+        return s_shadowParams[2];
+    default:
+    case InternalSettings::ShadowLarge:
+        return s_shadowParams[3];
+    case InternalSettings::ShadowVeryLarge:
+        return s_shadowParams[4];
+    }
+}
+
+BoxShadowHelper::ShadowGenerator generatorFor(int quality)
+{
+    switch (quality) {
+    default:
+    case InternalSettings::ShadowQualityFast:
+        // Both shadows are blurred rectangles, so build them from 1-D
+        // profiles instead of blurring a whole image. ShadowGenerator::BoxBlur
+        // is the reference to compare against.
+        return BoxShadowHelper::ShadowGenerator::SeparableBox;
+    case InternalSettings::ShadowQualityBalanced:
+        return BoxShadowHelper::ShadowGenerator::SeparableGaussian;
+    case InternalSettings::ShadowQualityExact:
+        return BoxShadowHelper::ShadowGenerator::ExactGaussian;
+    }
+}
+
+namespace
+{
+
+// Enough for the alpha planes of every preset at a couple of ratios.
+const int s_maxGeometryCostKiB = 16 * 1024;
+
+struct GeometryKey
+{
+    int preset;
+    int quality;
+    int cornerRadius;
+    int devicePixelRatio; // in percent
+
+    bool operator==(const GeometryKey &other) const
+    {
+        return preset == other.preset
+            && quality == other.quality
+            && cornerRadius == other.cornerRadius
+            && devicePixelRatio == other.devicePixelRatio;
+    }
+};
+
+uint qHash(const GeometryKey &key, uint seed = 0)
+{
+    return ::qHash(key.preset, seed)
+        ^ ::qHash(key.quality, seed) << 4
+        ^ ::qHash(key.cornerRadius, seed) << 8
+        ^ ::qHash(key.devicePixelRatio, seed) << 16;
+}
+
+QMutex s_geometryMutex;
+QCache<GeometryKey, ShadowGeometry> s_geometryCache(s_maxGeometryCostKiB);
+
+GeometryKey geometryKey(const ShadowKey &key)
+{
+    return { key.preset, key.quality, key.cornerRadius, qRound(key.devicePixelRatio * 100) };
+}
+
+// KWin stretches the row and the column of innerShadowRect across the
+// window edges. Rows and columns next to them that come out exactly the
+// same are redundant, so the texture is generated without them. That is
+// the case wherever every layer has the same alpha, the mask covers them
+// all alike. Only rows and columns behind the window are considered, so
+// the corner tiles keep covering the whole padding.
+QRect stretchRect(const ShadowGeometry &geometry)
+{
+    const QRect &mask = geometry.mask;
+    const QPoint center = QRect(QPoint(0, 0), geometry.size).center();
+
+    auto sameRow = [&geometry](int a, int b) {
+        for (const auto &layer : geometry.layers) {
+            const int rowA = a - layer.topLeft.y();
+            const int rowB = b - layer.topLeft.y();
+            const bool insideA = rowA >= 0 && rowA < layer.alpha.height();
+            const bool insideB = rowB >= 0 && rowB < layer.alpha.height();
+            if (insideA != insideB) {
+                return false;
+            }
+            if (insideA && std::memcmp(layer.alpha.constScanLine(rowA),
+                                       layer.alpha.constScanLine(rowB),
+                                       layer.alpha.width()) != 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+    auto sameColumn = [&geometry](int a, int b) {
+        for (const auto &layer : geometry.layers) {
+            const int columnA = a - layer.topLeft.x();
+            const int columnB = b - layer.topLeft.x();
+            const bool insideA = columnA >= 0 && columnA < layer.alpha.width();
+            const bool insideB = columnB >= 0 && columnB < layer.alpha.width();
+            if (insideA != insideB) {
+                return false;
+            }
+            if (!insideA) {
+                continue;
+            }
+            for (int y = 0; y < layer.alpha.height(); ++y) {
+                const uchar *line = layer.alpha.constScanLine(y);
+                if (line[columnA] != line[columnB]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    int top = center.y();
+    while (top > mask.top() && sameRow(top - 1, center.y())) {
+        --top;
+    }
+    int bottom = center.y();
+    while (bottom < mask.bottom() && sameRow(bottom + 1, center.y())) {
+        ++bottom;
+    }
+    int left = center.x();
+    while (left > mask.left() && sameColumn(left - 1, center.x())) {
+        --left;
+    }
+    int right = center.x();
+    while (right < mask.right() && sameColumn(right + 1, center.x())) {
+        ++right;
+    }
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+ShadowGeometry blurGeometry(const ShadowKey &key, const CompositeShadowParams &params)
+{
+    const qreal dpr = key.devicePixelRatio;
+
+    const auto generator = generatorFor(key.quality);
+
+    // In order to properly render a box shadow that reaches `shadowSize` past
+    // its box, the box size should be at least `2 * QSize(shadowSize, shadowSize)`.
+    const int shadowSize = qMax(
+        BoxShadowHelper::shadowExtent(params.shadow1.radius, generator),
+        BoxShadowHelper::shadowExtent(params.shadow2.radius, generator));
+    // Rounded corners push the straight part of the edges further in.
+    const int boxRadius = shadowSize + key.cornerRadius;
+    const QSize boxSize = QSize(1, 1) + QSize(boxRadius*2, boxRadius*2);
+    const QRect box(QPoint(shadowSize, shadowSize), boxSize);
+    const QRect rect = box.adjusted(-shadowSize, -shadowSize, shadowSize, shadowSize);
+
+    auto layerFor = [&](const ShadowParams &shadow) {
+        BoxShadowHelper::ShadowLayer layer;
+        layer.alpha = key.cornerRadius > 0
+            ? BoxShadowHelper::roundedShadowAlpha(box.size(), shadow.radius, key.cornerRadius, dpr, generator)
+            : BoxShadowHelper::boxShadowAlpha(box.size(), shadow.radius, dpr, generator);
+
+        QRect shadowRect(QPoint(0, 0), layer.alpha.size() / dpr);
+        shadowRect.moveCenter(box.center() + shadow.offset);
+        layer.topLeft = shadowRect.topLeft() * dpr;
+        return layer;
+    };
+
+    ShadowGeometry geometry;
+    geometry.layers = { layerFor(params.shadow1), layerFor(params.shadow2) };
+    geometry.size = rect.size() * dpr;
+    geometry.padding = params.padding(shadowSize);
+    geometry.mask = QRect(QPoint(0, 0), geometry.size) - geometry.padding * dpr;
+    geometry.stretch = stretchRect(geometry);
+    return geometry;
+}
+
+ShadowTexture tintLayers(const ShadowKey &key, const CompositeShadowParams &params, const ShadowGeometry &geometry)
+{
+    auto withOpacity = [] (const QColor &color, qreal opacity) -> QColor {
+        QColor c(color);
+        c.setAlphaF(opacity);
+        return c;
+    };
+
+    const QColor shadowColor = QColor::fromRgba(key.color);
+    const qreal shadowStrength = static_cast<qreal>(key.strength) / 255.0;
+    const qreal dpr = key.devicePixelRatio;
+
+    // Copies of the layers share their planes, so this doesn't allocate.
+    BoxShadowHelper::ShadowLayer layers[] = { geometry.layers.at(0), geometry.layers.at(1) };
+    layers[0].color = withOpacity(shadowColor, params.shadow1.opacity * shadowStrength);
+    layers[1].color = withOpacity(shadowColor, params.shadow2.opacity * shadowStrength);
+
+    // Draw the "shape" shadow, then the "contrast" shadow on top of it, and
+    // mask out window+titlebar from them in the same pass. The redundant
+    // middle of the nine-patch is never generated, so this writes the
+    // final texture directly.
+    const QRect &stretch = geometry.stretch;
+    QImage shadowTexture(geometry.size - stretch.size() + QSize(1, 1), QImage::Format_ARGB32_Premultiplied);
+    BoxShadowHelper::compositeShadows(shadowTexture.bits(), shadowTexture.bytesPerLine(),
+                                      geometry.size, layers, 2, geometry.mask, stretch);
+    shadowTexture.setDevicePixelRatio(dpr);
+
+    ShadowTexture texture;
+    texture.image = shadowTexture;
+    texture.padding = geometry.padding;
+    // Both the texture and innerShadowRect are in device pixels.
+    texture.innerShadowRect = QRect(stretch.topLeft(), QSize(1, 1));
+    return texture;
+}
+
+} // anonymous namespace
+
+bool isNone(int preset)
+{
+    return lookupShadowParams(preset).isNone();
+}
+
+ShadowGeometry cachedGeometry(const ShadowKey &key)
+{
+    QMutexLocker locker(&s_geometryMutex);
+    const ShadowGeometry *cached = s_geometryCache.object(geometryKey(key));
+    // Hand out a copy, the cache may evict the original at any time.
+    // The alpha planes are implicitly shared, so this doesn't allocate.
+    return cached ? *cached : ShadowGeometry();
+}
+
+void cacheGeometry(const ShadowKey &key, const ShadowGeometry &geometry)
+{
+    if (geometry.isNull()) {
+        return;
+    }
+
+    int cost = 0;
+    for (const auto &layer : geometry.layers) {
+        cost += static_cast<int>(layer.alpha.sizeInBytes() / 1024);
+    }
+
+    QMutexLocker locker(&s_geometryMutex);
+    s_geometryCache.insert(geometryKey(key), new ShadowGeometry(geometry), qMax(1, cost));
+}
+
+ShadowGeometry blur(const ShadowKey &key)
+{
+    const CompositeShadowParams params = lookupShadowParams(key.preset);
+    if (params.isNone()) { // InternalSettings::ShadowNone
+        return {};
+    }
+
+    return blurGeometry(key, params);
+}
+
+ShadowTexture tint(const ShadowKey &key, const ShadowGeometry &geometry)
+{
+    const CompositeShadowParams params = lookupShadowParams(key.preset);
+    if (params.isNone() || geometry.isNull()) {
+        return {};
+    }
+    return tintLayers(key, params, geometry);
+}
+
+ShadowTexture render(const ShadowKey &key)
+{
+    ShadowGeometry geometry = cachedGeometry(key);
+    if (geometry.isNull()) {
+        geometry = blur(key);
+        cacheGeometry(key, geometry);
+    }
+    return tint(key, geometry);
+}
+
+ShadowTexture retint(const ShadowKey &key)
+{
+    return tint(key, cachedGeometry(key));
+}
+
+void clearCache()
+{
+    QMutexLocker locker(&s_geometryMutex);
+    s_geometryCache.clear();
+}
+
+} // namespace ShadowRenderer
+} // namespace Material
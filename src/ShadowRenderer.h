@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// own
+#include "BoxShadowHelper.h"
+#include "ShadowCache.h"
+
+// Qt
+#include <QImage>
+#include <QMargins>
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+
+namespace Material
+{
+
+// A finished shadow nine-patch. The image and innerShadowRect are in
+// device pixels, the padding is in logical pixels.
+struct ShadowTexture
+{
+    QImage image;
+    QMargins padding;
+    QRect innerShadowRect;
+
+    bool isNull() const { return image.isNull(); }
+};
+
+namespace ShadowRenderer
+{
+
+// The presets are constexpr, so they live in read-only data.
+struct ShadowParams
+{
+    constexpr ShadowParams() = default;
+
+    constexpr ShadowParams(const QPoint &offset, int radius, qreal opacity)
+        : offset(offset)
+        , radius(radius)
+        , opacity(opacity) {}
+
+    QPoint offset;
+    int radius = 0;
+    qreal opacity = 0;
+};
+
+struct CompositeShadowParams
+{
+    constexpr CompositeShadowParams() = default;
+
+    constexpr CompositeShadowParams(
+            const QPoint &offset,
+            const ShadowParams &shadow1,
+            const ShadowParams &shadow2)
+        : offset(offset)
+        , shadow1(shadow1)
+        , shadow2(shadow2) {}
+
+    constexpr bool isNone() const {
+        return qMax(shadow1.radius, shadow2.radius) == 0;
+    }
+
+    // Padding of a texture that reaches `shadowSize` past the window on
+    // each side, shifted by the offset.
+    constexpr QMargins padding(int shadowSize) const {
+        return QMargins(
+            shadowSize - offset.x(),
+            shadowSize - offset.y(),
+            shadowSize + offset.x(),
+            shadowSize + offset.y());
+    }
+
+    QPoint offset;
+    ShadowParams shadow1;
+    ShadowParams shadow2;
+};
+
+// Parameters of an InternalSettings::EnumShadowSize preset.
+CompositeShadowParams lookupShadowParams(int size);
+
+// The generator an InternalSettings::EnumShadowQuality setting blurs with.
+BoxShadowHelper::ShadowGenerator generatorFor(int quality);
+
+// Bump whenever blur() produces different planes, so planes cached on
+// disk by older versions are thrown away.
+constexpr int generatorVersion = 3;
+
+bool isNone(int preset);
+
+// The blurred part of a shadow. It only depends on the preset, the quality,
+// the corner radius and the device pixel ratio, so color and strength
+// changes reuse it.
+struct ShadowGeometry
+{
+    QVector<BoxShadowHelper::ShadowLayer> layers; // without colors
+    QSize size;                                   // in device pixels
+    QMargins padding;
+    QRect mask;                                   // in device pixels
+    QRect stretch;                                // in device pixels, the part KWin stretches
+
+    bool isNull() const { return layers.isEmpty(); }
+};
+
+// The building blocks of render(), all safe to call from worker threads.
+// The blurred planes are cached per preset, quality, corner radius and
+// device pixel ratio, so only the first shadow of each geometry pays for
+// the blur. cachedGeometry() returns a null geometry on a miss, blur()
+// renders the planes and cacheGeometry() adds them to the cache.
+ShadowGeometry cachedGeometry(const ShadowKey &key);
+ShadowGeometry blur(const ShadowKey &key);
+void cacheGeometry(const ShadowKey &key, const ShadowGeometry &geometry);
+ShadowTexture tint(const ShadowKey &key, const ShadowGeometry &geometry);
+
+// Renders the shadow described by `key`, from the cached planes if there
+// are some.
+ShadowTexture render(const ShadowKey &key);
+
+// Like render(), but returns a null texture unless the blurred planes are
+// cached already. What's left is a single tint pass, cheap enough to run
+// on the GUI thread when only the color or strength changed.
+ShadowTexture retint(const ShadowKey &key);
+
+// Drops the cached alpha planes.
+void clearCache();
+
+} // namespace ShadowRenderer
+} // namespace Material
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "InternalSettings.h"
+#include "ScratchArena.h"
+#include "ShadowRenderer.h"
+
+// Qt
+#include <QtTest>
+
+// std
+#include <atomic>
+#include <cstdlib>
+
+namespace
+{
+
+// Counts every heap allocation made by the thread that turned counting on.
+thread_local bool t_counting = false;
+std::atomic<int> s_allocations(0);
+
+inline void countAllocation()
+{
+    if (t_counting) {
+        ++s_allocations;
+    }
+}
+
+class AllocationCounter
+{
+public:
+    AllocationCounter()
+    {
+        s_allocations = 0;
+        t_counting = true;
+    }
+
+    ~AllocationCounter()
+    {
+        t_counting = false;
+    }
+
+    int count() const
+    {
+        return s_allocations;
+    }
+};
+
+} // anonymous namespace
+
+#if defined(__GLIBC__)
+// QImage pixels and Qt's containers come straight from malloc(), and
+// operator new ends up there too, so counting at this level sees all of
+// them. The executable's definitions take precedence over libc's for every
+// library, the real allocator is still reachable through its __libc_ names.
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size) __THROW
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) __THROW
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) __THROW
+{
+    countAllocation();
+    return __libc_realloc(pointer, size);
+}
+
+} // extern "C"
+#define COUNTS_ALLOCATIONS
+#endif
+
+using namespace Material;
+
+class ShadowAllocationTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void retint_data();
+    void retint();
+    void rebuild_data();
+    void rebuild();
+};
+
+namespace
+{
+
+void addRows()
+{
+    QTest::addColumn<int>("preset");
+    QTest::addColumn<qreal>("dpr");
+
+    QTest::newRow("Small@1") << int(InternalSettings::ShadowSmall) << qreal(1);
+    QTest::newRow("VeryLarge@1") << int(InternalSettings::ShadowVeryLarge) << qreal(1);
+    QTest::newRow("VeryLarge@2") << int(InternalSettings::ShadowVeryLarge) << qreal(2);
+}
+
+} // anonymous namespace
+
+void ShadowAllocationTest::init()
+{
+#if !defined(COUNTS_ALLOCATIONS)
+    QSKIP("Counting allocations needs glibc");
+#endif
+}
+
+void ShadowAllocationTest::retint_data()
+{
+    addRows();
+}
+
+void ShadowAllocationTest::retint()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    ShadowKey key;
+    key.preset = preset;
+    key.devicePixelRatio = dpr;
+    key.color = qRgb(33, 33, 33);
+
+    // Blurs the planes and caches them.
+    QVERIFY(!ShadowRenderer::render(key).isNull());
+
+    // Another color, so only the tint pass runs. It doesn't use the
+    // scratch arena.
+    key.color = qRgb(0, 0, 0);
+
+    ShadowTexture texture;
+    int allocations = 0;
+    {
+        AllocationCounter counter;
+        texture = ShadowRenderer::render(key);
+        allocations = counter.count();
+    }
+
+    QVERIFY(!texture.isNull());
+
+    // The texture's QImage and its pixels, and nothing else.
+    QCOMPARE(allocations, 2);
+}
+
+void ShadowAllocationTest::rebuild_data()
+{
+    addRows();
+}
+
+void ShadowAllocationTest::rebuild()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    ShadowKey key;
+    key.preset = preset;
+    key.devicePixelRatio = dpr;
+    key.color = qRgb(33, 33, 33);
+
+    // Grows the scratch arena and caches the planes.
+    QVERIFY(!ShadowRenderer::render(key).isNull());
+    const size_t arenaCapacity = ScratchArena::local().capacity();
+
+    // What ShadowCache's worker does when the planes aren't cached: blur
+    // them again, cache them and tint them. The new planes replace the
+    // cached ones, so the cache's table is already there.
+    ShadowTexture texture;
+    int allocations = 0;
+    {
+        AllocationCounter counter;
+        const ShadowGeometry geometry = ShadowRenderer::blur(key);
+        ShadowRenderer::cacheGeometry(key, geometry);
+        texture = ShadowRenderer::tint(key, geometry);
+        allocations = counter.count();
+    }
+
+    QVERIFY(!texture.isNull());
+    QCOMPARE(ScratchArena::local().capacity(), arenaCapacity);
+
+    // Profiles, weights and anything else per row or per pixel come out of
+    // the scratch arena. What is left doesn't depend on the shadow:
+    // - the alpha plane of each of the two layers, a QImageData and its
+    //   pixels each (4)
+    // - the QVector holding the layers (1)
+    // - the cache's copy of the geometry and its QHash node (2)
+    // - the texture, a QImageData and its pixels (2)
+    QCOMPARE(allocations, 9);
+}
+
+QTEST_GUILESS_MAIN(ShadowAllocationTest)
+
+#include "ShadowAllocationTest.moc"
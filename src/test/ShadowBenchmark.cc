@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "BoxBlur.h"
+#include "BoxShadowHelper.h"
+#include "ShadowRenderer.h"
+#include "ShadowTestHelpers.h"
+
+// Qt
+#include <QtTest>
+
+using namespace Material;
+using namespace ShadowTest;
+
+// Timings of the shadow pipeline. The golden checks that keep the faster
+// paths honest are in ShadowGoldenTest, which runs with ctest.
+class ShadowBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void computeBoxSizes_data();
+    void computeBoxSizes();
+    void boxBlurPass_data();
+    void boxBlurPass();
+    void boxBlurAlpha_data();
+    void boxBlurAlpha();
+    void boxShadow_data();
+    void boxShadow();
+    void roundedShadowAlpha_data();
+    void roundedShadowAlpha();
+    void render_data();
+    void render();
+    void retint_data();
+    void retint();
+    void quality_data();
+    void quality();
+};
+
+void ShadowBenchmark::initTestCase()
+{
+    qInfo() << "Box blur backend:" << BoxBlur::backendName(BoxBlur::preferredBackend());
+}
+
+void ShadowBenchmark::computeBoxSizes_data()
+{
+    addPresetRows();
+}
+
+void ShadowBenchmark::computeBoxSizes()
+{
+    QFETCH(int, preset);
+
+    const auto params = ShadowRenderer::lookupShadowParams(preset);
+    QBENCHMARK {
+        BoxShadowHelper::computeBoxSizes(params.shadow1.radius, 3);
+        BoxShadowHelper::computeBoxSizes(params.shadow2.radius, 3);
+    }
+}
+
+void ShadowBenchmark::boxBlurPass_data()
+{
+    addPresetRows();
+}
+
+void ShadowBenchmark::boxBlurPass()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    const auto params = ShadowRenderer::lookupShadowParams(preset);
+    const int radius = shadowSize(params);
+    const QImage src = rasterizedBox(shadowBox(params).size(), radius, dpr);
+    QImage dst(src.height(), src.width(), src.format());
+    const int boxSize = BoxShadowHelper::computeBoxSizes(qRound(radius * dpr), 3).constLast();
+
+    QBENCHMARK {
+        BoxShadowHelper::boxBlurPass(src, dst, boxSize);
+    }
+}
+
+void ShadowBenchmark::boxBlurAlpha_data()
+{
+    addPresetRows();
+}
+
+void ShadowBenchmark::boxBlurAlpha()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    const auto params = ShadowRenderer::lookupShadowParams(preset);
+    const int radius = shadowSize(params);
+    const QImage src = rasterizedBox(shadowBox(params).size(), radius, dpr);
+
+    QBENCHMARK {
+        QImage image = src.copy();
+        BoxShadowHelper::boxBlurAlpha(image, qRound(radius * dpr), 3);
+    }
+}
+
+void ShadowBenchmark::boxShadow_data()
+{
+    addPresetRows();
+}
+
+void ShadowBenchmark::boxShadow()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    const auto params = ShadowRenderer::lookupShadowParams(preset);
+    QBENCHMARK {
+        painterTexture(params, dpr, BoxShadowHelper::ShadowGenerator::BoxBlur);
+    }
+}
+
+void ShadowBenchmark::roundedShadowAlpha_data()
+{
+    addPresetRows();
+}
+
+void ShadowBenchmark::roundedShadowAlpha()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    const auto params = ShadowRenderer::lookupShadowParams(preset);
+    const QSize box = shadowBox(params).size();
+
+    // Compare with boxShadow(), which blurs square corners.
+    QBENCHMARK {
+        BoxShadowHelper::roundedShadowAlpha(box, params.shadow1.radius, 8, dpr);
+        BoxShadowHelper::roundedShadowAlpha(box, params.shadow2.radius, 8, dpr);
+    }
+}
+
+void ShadowBenchmark::render_data()
+{
+    addPresetRows();
+}
+
+void ShadowBenchmark::render()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    ShadowKey key;
+    key.preset = preset;
+    key.color = s_shadowColor.rgba();
+    key.devicePixelRatio = dpr;
+
+    // The whole texture build of Decoration::updateShadow(), blur included.
+    QBENCHMARK {
+        ShadowRenderer::clearCache();
+        QVERIFY(!ShadowRenderer::render(key).isNull());
+    }
+}
+
+void ShadowBenchmark::retint_data()
+{
+    addPresetRows();
+}
+
+void ShadowBenchmark::retint()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    ShadowKey key;
+    key.preset = preset;
+    key.color = s_shadowColor.rgba();
+    key.devicePixelRatio = dpr;
+    ShadowRenderer::render(key);
+
+    // A color change: the blurred planes are reused.
+    QBENCHMARK {
+        QVERIFY(!ShadowRenderer::retint(key).isNull());
+    }
+}
+
+void ShadowBenchmark::quality_data()
+{
+    addQualityRows();
+}
+
+void ShadowBenchmark::quality()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+    QFETCH(int, quality);
+
+    ShadowKey key;
+    key.preset = preset;
+    key.quality = quality;
+    key.color = s_shadowColor.rgba();
+    key.devicePixelRatio = dpr;
+
+    // What each quality setting costs for a full texture build.
+    QBENCHMARK {
+        ShadowRenderer::clearCache();
+        QVERIFY(!ShadowRenderer::render(key).isNull());
+    }
+}
+
+QTEST_GUILESS_MAIN(ShadowBenchmark)
+
+#include "ShadowBenchmark.moc"
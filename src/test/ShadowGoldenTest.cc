@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "BoxBlur.h"
+#include "BoxShadowHelper.h"
+#include "InternalSettings.h"
+#include "ShadowRenderer.h"
+#include "ShadowTestHelpers.h"
+
+// Qt
+#include <QtMath> // M_SQRT2
+#include <QtTest>
+
+// std
+#include <cmath>
+#include <cstdlib>
+
+using namespace Material;
+using namespace ShadowTest;
+
+namespace
+{
+
+// Measured worst case of SeparableBox against the 2-D box blur, caused
+// by the reference truncating after every pass.
+const int s_separableTolerance = 3;
+
+// Quantization plus the tail ExactGaussian's kernel cuts off.
+const qreal s_exactTolerance = 2;
+
+// The CSS box shadow: the box convolved with a Gaussian of half the radius,
+// in 8-bit levels, without quantization. The plane is padded like the
+// ExactGaussian one.
+QVector<qreal> exactShadowAlpha(const QSize &box, int radius, qreal dpr, QSize &size)
+{
+    const int extent = BoxShadowHelper::shadowExtent(radius, BoxShadowHelper::ShadowGenerator::ExactGaussian);
+    size = (box + 2 * QSize(extent, extent)) * dpr;
+
+    auto profile = [&](int length, int begin, int end) {
+        const qreal scale = 1.0 / (radius * dpr * 0.5 * M_SQRT2);
+        QVector<qreal> values(length);
+        for (int x = 0; x < length; ++x) {
+            const qreal center = x + 0.5;
+            values[x] = 0.5 * (std::erf((center - begin) * scale) - std::erf((center - end) * scale));
+        }
+        return values;
+    };
+
+    const int left = qRound(extent * dpr);
+    const int top = qRound(extent * dpr);
+    const QVector<qreal> columns = profile(size.width(), left, qMin(qRound((extent + box.width()) * dpr), size.width()));
+    const QVector<qreal> rows = profile(size.height(), top, qMin(qRound((extent + box.height()) * dpr), size.height()));
+
+    QVector<qreal> alpha(size.width() * size.height());
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            alpha[y * size.width() + x] = 255 * columns[x] * rows[y];
+        }
+    }
+    return alpha;
+}
+
+// Largest error of an alpha plane against exactShadowAlpha(). Planes that
+// don't reach as far are centered, everything past them counts as 0.
+qreal maxErrorAgainstExact(const QImage &alpha, const QVector<qreal> &exact, const QSize &exactSize)
+{
+    const int offsetX = (exactSize.width() - alpha.width()) / 2;
+    const int offsetY = (exactSize.height() - alpha.height()) / 2;
+
+    qreal error = 0;
+    for (int y = 0; y < exactSize.height(); ++y) {
+        const int alphaY = y - offsetY;
+        for (int x = 0; x < exactSize.width(); ++x) {
+            const int alphaX = x - offsetX;
+            const bool inside = alphaX >= 0 && alphaX < alpha.width()
+                && alphaY >= 0 && alphaY < alpha.height();
+            const qreal value = inside ? alpha.constScanLine(alphaY)[alphaX] : 0;
+            error = qMax(error, std::abs(value - exact[y * exactSize.width() + x]));
+        }
+    }
+    return error;
+}
+
+// Kovesi's box sizes the way they were computed before they became
+// constexpr, with a sigma of 0.4375 times the radius.
+QVector<int> floatingBoxSizes(int radius)
+{
+    const int numIterations = 3;
+    const qreal sigma = radius * 0.4375;
+
+    int lower = std::floor(std::sqrt(12 * std::pow(sigma, 2) / numIterations + 1));
+    if (lower % 2 == 0) {
+        lower--;
+    }
+
+    const int upper = lower + 2;
+    const int threshold = std::round((12 * std::pow(sigma, 2) - numIterations * std::pow(lower, 2)
+        - 4 * numIterations * lower - 3 * numIterations) / (-4 * lower - 4));
+
+    QVector<int> boxSizes;
+    for (int i = 0; i < numIterations; ++i) {
+        boxSizes.append(i < threshold ? lower : upper);
+    }
+    return boxSizes;
+}
+
+// Largest difference of any byte, the images must have the same geometry.
+int maxDifference(const QImage &a, const QImage &b)
+{
+    if (a.size() != b.size() || a.depth() != b.depth()) {
+        return 256;
+    }
+
+    const int rowBytes = a.width() * a.depth() / 8;
+    int difference = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        const uchar *lineA = a.constScanLine(y);
+        const uchar *lineB = b.constScanLine(y);
+        for (int x = 0; x < rowBytes; ++x) {
+            difference = qMax(difference, std::abs(lineA[x] - lineB[x]));
+        }
+    }
+    return difference;
+}
+
+// The same texture from the fused compositeShadows() kernel.
+QImage fusedTexture(const ShadowRenderer::CompositeShadowParams &params, qreal dpr,
+                    BoxShadowHelper::ShadowGenerator generator)
+{
+    const QRect box = shadowBox(params);
+    const QSize size = (box.size() + 2 * QSize(shadowSize(params), shadowSize(params))) * dpr;
+
+    auto layerFor = [&](const ShadowRenderer::ShadowParams &shadow) {
+        BoxShadowHelper::ShadowLayer layer;
+        layer.alpha = BoxShadowHelper::boxShadowAlpha(box.size(), shadow.radius, dpr, generator);
+        layer.color = withOpacity(s_shadowColor, shadow.opacity);
+
+        QRect shadowRect(QPoint(0, 0), layer.alpha.size() / dpr);
+        shadowRect.moveCenter(box.center() + shadow.offset);
+        layer.topLeft = shadowRect.topLeft() * dpr;
+        return layer;
+    };
+
+    QImage texture(size, QImage::Format_ARGB32_Premultiplied);
+    texture.setDevicePixelRatio(dpr);
+    BoxShadowHelper::compositeShadows(
+        texture,
+        { layerFor(params.shadow1), layerFor(params.shadow2) },
+        texture.rect() - shadowPadding(params) * dpr);
+    return texture;
+}
+
+} // anonymous namespace
+
+// Golden checks: the faster paths of the shadow pipeline against their
+// references. The timings are in ShadowBenchmark.
+class ShadowGoldenTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void constexprBoxSizes();
+    void boxBlurBackends_data();
+    void boxBlurBackends();
+    void separableBox_data();
+    void separableBox();
+    void fusedComposite_data();
+    void fusedComposite();
+    void qualityError_data();
+    void qualityError();
+    void deviceRadius_data();
+    void deviceRadius();
+};
+
+void ShadowGoldenTest::initTestCase()
+{
+    // The SIMD backends are checked up to this one.
+    qInfo() << "Box blur backend:" << BoxBlur::backendName(BoxBlur::preferredBackend());
+}
+
+void ShadowGoldenTest::constexprBoxSizes()
+{
+    // Every device radius up to VeryLarge at 4x.
+    for (int radius = 0; radius <= 256; ++radius) {
+        const QVector<int> expected = floatingBoxSizes(radius);
+        for (int pass = 0; pass < 3; ++pass) {
+            QCOMPARE(BoxShadowHelper::boxSize(radius, pass), expected.at(pass));
+        }
+    }
+}
+
+void ShadowGoldenTest::boxBlurBackends_data()
+{
+    addPresetRows();
+}
+
+void ShadowGoldenTest::boxBlurBackends()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    const auto params = ShadowRenderer::lookupShadowParams(preset);
+    const QSize box = shadowBox(params).size();
+
+    for (const int radius : { params.shadow1.radius, params.shadow2.radius }) {
+        const QImage src = rasterizedBox(box, radius, dpr);
+        for (const int boxSize : BoxShadowHelper::computeBoxSizes(qRound(radius * dpr), 3)) {
+            BoxBlur::Pass pass;
+            pass.src = src.constBits();
+            pass.srcBytesPerLine = src.bytesPerLine();
+            pass.width = src.width();
+            pass.height = src.height();
+            pass.boxSize = boxSize;
+
+            QImage expected(src.height(), src.width(), QImage::Format_Alpha8);
+            pass.dst = expected.bits();
+            pass.dstBytesPerLine = expected.bytesPerLine();
+            BoxBlur::run(pass, BoxBlur::Backend::Scalar);
+
+            for (int backend = int(BoxBlur::Backend::Scalar) + 1;
+                    backend <= int(BoxBlur::preferredBackend()); ++backend) {
+                QImage actual(src.height(), src.width(), QImage::Format_Alpha8);
+                pass.dst = actual.bits();
+                pass.dstBytesPerLine = actual.bytesPerLine();
+                BoxBlur::run(pass, BoxBlur::Backend(backend));
+
+                QVERIFY2(maxDifference(expected, actual) == 0,
+                         BoxBlur::backendName(BoxBlur::Backend(backend)));
+            }
+        }
+    }
+}
+
+void ShadowGoldenTest::separableBox_data()
+{
+    addPresetRows();
+}
+
+void ShadowGoldenTest::separableBox()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    const auto params = ShadowRenderer::lookupShadowParams(preset);
+    const QSize box = shadowBox(params).size();
+
+    for (const int radius : { params.shadow1.radius, params.shadow2.radius }) {
+        const QImage expected = BoxShadowHelper::boxShadowAlpha(
+            box, radius, dpr, BoxShadowHelper::ShadowGenerator::BoxBlur);
+        const QImage actual = BoxShadowHelper::boxShadowAlpha(
+            box, radius, dpr, BoxShadowHelper::ShadowGenerator::SeparableBox);
+        QVERIFY(maxDifference(expected, actual) <= s_separableTolerance);
+    }
+}
+
+void ShadowGoldenTest::fusedComposite_data()
+{
+    // At fractional ratios drawImage() resamples, the fused kernel doesn't.
+    addPresetRows(true);
+}
+
+void ShadowGoldenTest::fusedComposite()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+
+    const auto params = ShadowRenderer::lookupShadowParams(preset);
+    const auto generator = BoxShadowHelper::ShadowGenerator::SeparableBox;
+
+    // One step of rounding slack for Qt's own blend functions.
+    QVERIFY(maxDifference(painterTexture(params, dpr, generator),
+                          fusedTexture(params, dpr, generator)) <= 1);
+}
+
+void ShadowGoldenTest::qualityError_data()
+{
+    addQualityRows();
+}
+
+void ShadowGoldenTest::qualityError()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+    QFETCH(int, quality);
+
+    const auto params = ShadowRenderer::lookupShadowParams(preset);
+    const QSize box = shadowBox(params).size();
+
+    qreal error = 0;
+    for (const int radius : { params.shadow1.radius, params.shadow2.radius }) {
+        QSize exactSize;
+        const QVector<qreal> exact = exactShadowAlpha(box, radius, dpr, exactSize);
+        const QImage alpha = BoxShadowHelper::boxShadowAlpha(box, radius, dpr, ShadowRenderer::generatorFor(quality));
+        error = qMax(error, maxErrorAgainstExact(alpha, exact, exactSize));
+    }
+
+    // The report the quality setting is chosen from.
+    qInfo("%s: max error %.2f of 255", QTest::currentDataTag(), error);
+
+    if (quality == InternalSettings::ShadowQualityExact) {
+        QVERIFY(error <= s_exactTolerance);
+    }
+}
+
+void ShadowGoldenTest::deviceRadius_data()
+{
+    addQualityRows();
+}
+
+void ShadowGoldenTest::deviceRadius()
+{
+    QFETCH(int, preset);
+    QFETCH(qreal, dpr);
+    QFETCH(int, quality);
+
+    if (dpr != qRound(dpr)) {
+        QSKIP("The scaled box would need a fractional size");
+    }
+
+    const auto params = ShadowRenderer::lookupShadowParams(preset);
+    const QSize box = shadowBox(params).size();
+    const int scale = qRound(dpr);
+    const auto generator = ShadowRenderer::generatorFor(quality);
+
+    // Radii are in logical pixels, like the box. A plane rendered at `dpr`
+    // has to match the 1x plane of a box and radius scaled by `dpr`, or
+    // shadows come out too sharp on HiDPI screens. The planes may differ in
+    // how far they reach, so only their common middle is compared.
+    for (const int radius : { params.shadow1.radius, params.shadow2.radius }) {
+        const QImage actual = BoxShadowHelper::boxShadowAlpha(box, radius, dpr, generator);
+        const QImage expected = BoxShadowHelper::boxShadowAlpha(box * scale, radius * scale, 1, generator);
+
+        const bool actualLarger = actual.width() > expected.width();
+        const QImage &larger = actualLarger ? actual : expected;
+        const QImage &smaller = actualLarger ? expected : actual;
+        QRect middle(QPoint(0, 0), smaller.size());
+        middle.moveCenter(larger.rect().center());
+        QVERIFY(maxDifference(larger.copy(middle), smaller) <= 1);
+    }
+}
+
+QTEST_GUILESS_MAIN(ShadowGoldenTest)
+
+#include "ShadowGoldenTest.moc"
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// own
+#include "ShadowTestHelpers.h"
+#include "InternalSettings.h"
+
+// Qt
+#include <QPainter>
+#include <QtTest>
+
+// std
+#include <cstring>
+
+using namespace Material;
+
+namespace ShadowTest
+{
+
+namespace
+{
+const qreal s_devicePixelRatios[] = { 1, 1.5, 2, 3 };
+} // anonymous namespace
+
+QString presetName(int preset)
+{
+    switch (preset) {
+    case InternalSettings::ShadowSmall:
+        return QStringLiteral("Small");
+    case InternalSettings::ShadowMedium:
+        return QStringLiteral("Medium");
+    case InternalSettings::ShadowLarge:
+        return QStringLiteral("Large");
+    case InternalSettings::ShadowVeryLarge:
+        return QStringLiteral("VeryLarge");
+    default:
+        return QStringLiteral("None");
+    }
+}
+
+QString qualityName(int quality)
+{
+    switch (quality) {
+    case InternalSettings::ShadowQualityBalanced:
+        return QStringLiteral("Balanced");
+    case InternalSettings::ShadowQualityExact:
+        return QStringLiteral("Exact");
+    default:
+        return QStringLiteral("Fast");
+    }
+}
+
+void addPresetRows(bool integerRatiosOnly)
+{
+    QTest::addColumn<int>("preset");
+    QTest::addColumn<qreal>("dpr");
+
+    for (int preset = InternalSettings::ShadowSmall; preset <= InternalSettings::ShadowVeryLarge; ++preset) {
+        for (const qreal dpr : s_devicePixelRatios) {
+            if (integerRatiosOnly && dpr != qRound(dpr)) {
+                continue;
+            }
+            const QByteArray name = QStringLiteral("%1@%2").arg(presetName(preset)).arg(dpr).toLatin1();
+            QTest::newRow(name.constData()) << preset << dpr;
+        }
+    }
+}
+
+void addQualityRows()
+{
+    QTest::addColumn<int>("preset");
+    QTest::addColumn<qreal>("dpr");
+    QTest::addColumn<int>("quality");
+
+    for (int preset = InternalSettings::ShadowSmall; preset <= InternalSettings::ShadowVeryLarge; ++preset) {
+        for (const qreal dpr : s_devicePixelRatios) {
+            for (int quality = InternalSettings::ShadowQualityFast; quality <= InternalSettings::ShadowQualityExact; ++quality) {
+                const QByteArray name = QStringLiteral("%1@%2/%3")
+                    .arg(presetName(preset)).arg(dpr).arg(qualityName(quality)).toLatin1();
+                QTest::newRow(name.constData()) << preset << dpr << quality;
+            }
+        }
+    }
+}
+
+int shadowSize(const ShadowRenderer::CompositeShadowParams &params)
+{
+    return qMax(params.shadow1.radius, params.shadow2.radius);
+}
+
+QRect shadowBox(const ShadowRenderer::CompositeShadowParams &params)
+{
+    const int size = shadowSize(params);
+    return QRect(QPoint(size, size), QSize(1, 1) + QSize(size * 2, size * 2));
+}
+
+QMargins shadowPadding(const ShadowRenderer::CompositeShadowParams &params)
+{
+    return params.padding(shadowSize(params));
+}
+
+QColor withOpacity(const QColor &color, qreal opacity)
+{
+    QColor c(color);
+    c.setAlphaF(opacity);
+    return c;
+}
+
+QImage rasterizedBox(const QSize &box, int radius, qreal dpr)
+{
+    const QSize size = (box + 2 * QSize(radius, radius)) * dpr;
+    QImage image(size, QImage::Format_Alpha8);
+    image.fill(0);
+
+    const int left = qRound(radius * dpr);
+    const int top = qRound(radius * dpr);
+    const int right = qMin(qRound((radius + box.width()) * dpr), size.width());
+    const int bottom = qMin(qRound((radius + box.height()) * dpr), size.height());
+    for (int y = top; y < bottom; ++y) {
+        std::memset(image.scanLine(y) + left, 0xff, right - left);
+    }
+    return image;
+}
+
+QImage painterTexture(const ShadowRenderer::CompositeShadowParams &params, qreal dpr,
+                      BoxShadowHelper::ShadowGenerator generator)
+{
+    const QRect box = shadowBox(params);
+    const QRect rect = box.adjusted(-shadowSize(params), -shadowSize(params),
+                                    shadowSize(params), shadowSize(params));
+
+    QImage texture(rect.size() * dpr, QImage::Format_ARGB32_Premultiplied);
+    texture.setDevicePixelRatio(dpr);
+    texture.fill(Qt::transparent);
+
+    QPainter painter(&texture);
+    painter.setRenderHint(QPainter::Antialiasing);
+    BoxShadowHelper::boxShadow(&painter, box, params.shadow1.offset, params.shadow1.radius,
+                               withOpacity(s_shadowColor, params.shadow1.opacity), generator);
+    BoxShadowHelper::boxShadow(&painter, box, params.shadow2.offset, params.shadow2.radius,
+                               withOpacity(s_shadowColor, params.shadow2.opacity), generator);
+
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(Qt::black);
+    painter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
+    painter.drawRect(rect - shadowPadding(params));
+    painter.end();
+
+    return texture;
+}
+
+} // namespace ShadowTest
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 material-decoration contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// own
+#include "BoxShadowHelper.h"
+#include "ShadowRenderer.h"
+
+// Qt
+#include <QColor>
+#include <QImage>
+#include <QMargins>
+#include <QRect>
+#include <QString>
+
+// Shared by the golden test and the benchmark.
+namespace ShadowTest
+{
+
+const QColor s_shadowColor = QColor(33, 33, 33);
+
+QString presetName(int preset);
+QString qualityName(int quality);
+
+// One row per preset and device pixel ratio.
+void addPresetRows(bool integerRatiosOnly = false);
+
+// One row per preset, device pixel ratio and quality.
+void addQualityRows();
+
+// Same geometry as ShadowRenderer: a box centered in a texture that is
+// padded by the largest radius on each side.
+int shadowSize(const Material::ShadowRenderer::CompositeShadowParams &params);
+QRect shadowBox(const Material::ShadowRenderer::CompositeShadowParams &params);
+QMargins shadowPadding(const Material::ShadowRenderer::CompositeShadowParams &params);
+
+QColor withOpacity(const QColor &color, qreal opacity);
+
+// Unblurred alpha plane as boxShadowAlpha() feeds it to the box blur.
+QImage rasterizedBox(const QSize &box, int radius, qreal dpr);
+
+// The texture the way it was built before the fused kernel: a QPainter
+// pass per layer and a DestinationOut fill for the window.
+QImage painterTexture(const Material::ShadowRenderer::CompositeShadowParams &params, qreal dpr,
+                      Material::BoxShadowHelper::ShadowGenerator generator);
+
+} // namespace ShadowTest